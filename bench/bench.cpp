@@ -0,0 +1,383 @@
+// === Микробенчмарки горячих участков ===
+// Каждый случай гоняется на N = min_n, 10 * min_n, ... max_n, пока не наберётся
+// min_time секунд. Результат — одна строка на (случай, N) в CSV или JSON,
+// чтобы прогоны можно было сравнивать скриптом.
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "ensemble.h"
+#include "sampler.h"
+#include "step_engine.h"
+#include "radial_stats.h"
+#include "moments.h"
+#include "stats.h"
+#include "trajectory.h"
+#include "gas.h"
+#include "passage.h"
+
+typedef struct BenchOptions {
+    int    min_n       = 1000;
+    int    max_n       = 10000000;
+    int    thread_count = 1;
+    double min_time    = 0.2;
+    bool   json        = false;
+    std::string filter; // пусто — все случаи
+} BenchOptions;
+
+typedef struct BenchResult {
+    std::string name;
+    int    n;
+    int    threads;
+    long   iterations;
+    double elapsed;
+    double items;      // сколько единиц работы сделано (частице-шагов, выборок, ...)
+    long   peak_rss_kb;
+} BenchResult;
+
+// Пиковый RSS процесса: монотонно растёт, поэтому случаи идут от малых N к большим
+static long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Повторяет body, пока его суммарное время не превысит min_time; body возвращает
+// число единиц работы. prepare (если есть) выполняется перед каждым body вне замера.
+// Первый вызов не засчитывается: он прогревает кэши и страницы.
+static BenchResult measure(const std::string& name, int n, int threads, double min_time,
+                           const std::function<double()>& body,
+                           const std::function<void()>& prepare = nullptr) {
+    BenchResult result = {name, n, threads, 0, 0.0, 0.0, 0};
+    if (prepare)
+        prepare();
+    body();
+
+    do {
+        if (prepare)
+            prepare();
+        auto start = std::chrono::steady_clock::now();
+        result.items += body();
+        result.elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++result.iterations;
+    } while (result.elapsed < min_time);
+
+    result.peak_rss_kb = peak_rss_kb();
+    return result;
+}
+
+static void print_header(const BenchOptions& options) {
+    if (options.json)
+        printf("[\n");
+    else
+        printf("case,n,threads,iterations,elapsed_sec,ns_per_item,items_per_sec,peak_rss_kb\n");
+}
+
+static void print_result(const BenchOptions& options, const BenchResult& r, bool first) {
+    const double ns_per_item = r.items > 0 ? r.elapsed * 1e9 / r.items : 0.0;
+    const double throughput  = r.elapsed > 0 ? r.items / r.elapsed : 0.0;
+
+    if (options.json) {
+        printf("%s  {\"case\": \"%s\", \"n\": %d, \"threads\": %d, \"iterations\": %ld, "
+               "\"elapsed_sec\": %.6f, \"ns_per_item\": %.4f, \"items_per_sec\": %.1f, \"peak_rss_kb\": %ld}",
+               first ? "" : ",\n", r.name.c_str(), r.n, r.threads, r.iterations,
+               r.elapsed, ns_per_item, throughput, r.peak_rss_kb);
+    } else {
+        printf("%s,%d,%d,%ld,%.6f,%.4f,%.1f,%ld\n", r.name.c_str(), r.n, r.threads, r.iterations,
+               r.elapsed, ns_per_item, throughput, r.peak_rss_kb);
+    }
+    fflush(stdout);
+}
+
+static void print_footer(const BenchOptions& options) {
+    if (options.json)
+        printf("\n]\n");
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--json] [--min-n N] [--max-n N] [-j THREADS] [--min-time SEC] [--case NAME]\n"
+            "  --json          JSON array instead of CSV\n"
+            "  --min-n N       smallest ensemble (default 1000)\n"
+            "  --max-n N       largest ensemble (default 10000000)\n"
+            "  -j THREADS      worker threads for the step engine\n"
+            "  --min-time SEC  minimal time per case (default 0.2)\n"
+            "  --case NAME     run only cases whose name contains NAME\n",
+            program);
+}
+
+static bool parse_args(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "--json")) {
+            options.json = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (!strcmp(arg, "--min-n"))
+            options.min_n = std::max(1, atoi(value));
+        else if (!strcmp(arg, "--max-n"))
+            options.max_n = std::max(1, atoi(value));
+        else if (!strcmp(arg, "-j"))
+            options.thread_count = std::clamp(atoi(value), 1, MAX_THREAD_COUNT);
+        else if (!strcmp(arg, "--min-time"))
+            options.min_time = std::max(0.0, atof(value));
+        else if (!strcmp(arg, "--case"))
+            options.filter = value;
+        else {
+            fprintf(stderr, "Unknown argument %s\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Случайный разброс позиций, чтобы гистограмма и траектории работали не с нулями
+static void scatter(ParticleEnsemble& particles, float sigma) {
+    std::mt19937 gen(12345);
+    std::normal_distribution<float> gauss(0.0f, sigma);
+    for (int i = 0; i < particles.count; ++i) {
+        particles.x[i] = gauss(gen);
+        particles.y[i] = gauss(gen);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    options.thread_count = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, MAX_THREAD_COUNT);
+    if (!parse_args(argc, argv, options)) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    const float lambda = DEFAULT_STEP_SIZE;
+    const unsigned seed = 7;
+    bool first = true;
+
+    auto wanted = [&](const char* name) {
+        return options.filter.empty() || strstr(name, options.filter.c_str()) != nullptr;
+    };
+    auto report = [&](const BenchResult& result) {
+        print_result(options, result, first);
+        first = false;
+    };
+
+    print_header(options);
+
+    for (long long n_wide = options.min_n; n_wide <= options.max_n; n_wide *= 10) {
+        const int n = static_cast<int>(n_wide);
+
+        // === Генератор: одна порция STEP_BLOCK на вызов, как в шаге ===
+        if (wanted("sampler_exponential") || wanted("sampler_gaussian")) {
+            BatchSampler sampler;
+            sampler.seed(seed, 0);
+            AlignedVector<float> a(STEP_BLOCK), b(STEP_BLOCK);
+            const std::string isa = sampler_isa_name(sampler.isa);
+
+            if (wanted("sampler_exponential"))
+                report(measure("sampler_exponential_" + isa, n, 1, options.min_time, [&] {
+                    for (int done = 0; done < n; done += STEP_BLOCK)
+                        sampler.fill_exponential(a.data(), std::min(STEP_BLOCK, n - done), lambda);
+                    return static_cast<double>(n);
+                }));
+            if (wanted("sampler_gaussian"))
+                report(measure("sampler_gaussian_" + isa, n, 1, options.min_time, [&] {
+                    for (int done = 0; done < n; done += STEP_BLOCK)
+                        sampler.fill_gaussian(a.data(), b.data(), std::min(STEP_BLOCK, n - done));
+                    return static_cast<double>(n);
+                }));
+        }
+
+        // === Шаг ансамбля: StepEngine в одном и в нескольких потоках, 2D и ядра 1D/3D ===
+        // Случаи с границей — область в 1000 длин пробега, почти все частицы внутри
+        static const struct { const char* name; int dimension; BoundaryKind boundary; } STEP_CASES[] = {
+            {"step_engine",            2, BOUNDARY_NONE},
+            {"step_engine_1d",         1, BOUNDARY_NONE},
+            {"step_engine_3d",         3, BOUNDARY_NONE},
+            {"step_engine_periodic",   2, BOUNDARY_PERIODIC},
+            {"step_engine_reflecting", 2, BOUNDARY_REFLECTING},
+            {"step_engine_absorbing",  2, BOUNDARY_ABSORBING},
+            {"step_engine_circular",   2, BOUNDARY_CIRCULAR}
+        };
+        for (const auto& step_case : STEP_CASES) {
+            if (!wanted(step_case.name))
+                continue;
+
+            ParticleEnsemble particles(n, step_case.dimension);
+            std::vector<int> thread_counts = {1};
+            if (options.thread_count > 1)
+                thread_counts.push_back(options.thread_count);
+
+            for (int threads : thread_counts) {
+                StepEngine engine(threads, seed, lambda, Domain{step_case.boundary, 1000.0f * lambda});
+                particles.reset();
+                report(measure(step_case.name, n, threads, options.min_time, [&] {
+                    // Поглощённые не считаются: элемент — частица, сделавшая шаг
+                    const int active = particles.count;
+                    engine.step(particles);
+                    return static_cast<double>(active);
+                }));
+            }
+        }
+
+        // === Шаг с монитором первого достижения трёх радиусов ===
+        if (wanted("step_passage")) {
+            ParticleEnsemble particles(n);
+            StepEngine engine(1, seed, lambda);
+            PassageMonitor passage;
+            passage.configure({10.0f * lambda, 30.0f * lambda, 100.0f * lambda}, engine.domain(), 2, lambda, n,
+                              engine.thread_count(), MAX_STEPS);
+            engine.attach_passage(&passage);
+            int step = 0;
+            report(measure("step_passage", n, 1, options.min_time, [&] {
+                engine.step(particles);
+                passage.record_step(++step, 0);
+                return static_cast<double>(n);
+            }));
+        }
+
+        // === Прежний цикл run_simulation: mt19937 и std-распределения по частице ===
+        if (wanted("step_legacy")) {
+            ParticleEnsemble particles(n);
+            std::mt19937 gen(seed);
+            std::exponential_distribution<float> poisson_dist(1.0f / lambda);
+            std::normal_distribution<float> gaussian_dist(0.0, 1.0);
+
+            report(measure("step_legacy", n, 1, options.min_time, [&] {
+                for (int i = 0; i < particles.count; ++i) {
+                    float step = poisson_dist(gen);
+                    particles.x[i] += gaussian_dist(gen) * step / std::sqrt(2.0f);
+                    particles.y[i] += gaussian_dist(gen) * step / std::sqrt(2.0f);
+                }
+                return static_cast<double>(n);
+            }));
+        }
+
+        // === Газ твёрдых дисков: полёт, сортировка по ячейкам и столкновения ===
+        if (wanted("gas_step")) {
+            ParticleEnsemble particles(n);
+            HardDiskGas gas;
+            if (gas.configure(particles, 1.0f, lambda, seed))
+                report(measure("gas_step", n, 1, options.min_time, [&] {
+                    gas.step(particles);
+                    return static_cast<double>(n);
+                }));
+        }
+
+        // === Радиальная гистограмма и кривые для графиков ===
+        if (wanted("radial_histogram") || wanted("moments_pass") || wanted("stats_cdf") || wanted("stats_pdf") ||
+            wanted("stats_fit")) {
+            ParticleEnsemble particles(n);
+            scatter(particles, lambda * 30);
+
+            if (wanted("radial_histogram")) {
+                RadialHistogram histogram;
+                report(measure("radial_histogram", n, 1, options.min_time, [&] {
+                    histogram.build(particles.x.data(), particles.y.data(), nullptr, particles.count);
+                    return static_cast<double>(n);
+                }));
+            }
+
+            // Отдельный проход — столько стоили бы моменты, если бы их не копило ядро шага
+            if (wanted("moments_pass"))
+                report(measure("moments_pass", n, 1, options.min_time, [&] {
+                    return static_cast<double>(measure_moments(particles, 1).count);
+                }));
+
+            // Новый номер шага на каждой итерации сбрасывает кэш EnsembleStats
+            EnsembleStats stats;
+            EnsembleMoments moments = measure_moments(particles, 1);
+            if (wanted("stats_cdf"))
+                report(measure("stats_cdf", n, 1, options.min_time, [&] {
+                    moments.step++;
+                    stats.bind(particles, moments, lambda, DEFAULT_DELAY);
+                    stats.cdf();
+                    return static_cast<double>(n);
+                }));
+            if (wanted("stats_pdf"))
+                report(measure("stats_pdf", n, 1, options.min_time, [&] {
+                    moments.step++;
+                    stats.bind(particles, moments, lambda, DEFAULT_DELAY);
+                    stats.pdf();
+                    return static_cast<double>(n);
+                }));
+            // Только KS и χ² по уже построенной гистограмме — O(бинов), без прохода по частицам
+            if (wanted("stats_fit")) {
+                RadialHistogram histogram;
+                histogram.build(particles.x.data(), particles.y.data(), nullptr, particles.count);
+                report(measure("stats_fit", n, 1, options.min_time, [&] {
+                    return chi_goodness(histogram, 2, lambda * lambda * 100.0).ks >= 0.0 ? 1.0 : 0.0;
+                }));
+            }
+        }
+
+        // === Запись траекторий в хранилище с бюджетом по умолчанию ===
+        static const struct { const char* name; PathPolicy policy; } PATH_CASES[] = {
+            {"path_ring",     PATH_RING},
+            {"path_stride",   PATH_STRIDE},
+            {"path_adaptive", PATH_ADAPTIVE}
+        };
+        for (const auto& path_case : PATH_CASES) {
+            if (!wanted(path_case.name))
+                continue;
+
+            TrajectoryStore paths;
+            paths.configure(n, path_case.policy, static_cast<size_t>(DEFAULT_PATH_BUDGET_MB) << 20, MAX_STEPS + 1);
+            if (!paths.enabled())
+                continue; // на такое N бюджета не хватает даже на минимальную историю
+
+            // Траектории — настоящие случайные блуждания; шаг движка идёт вне замера
+            ParticleEnsemble particles(n);
+            StepEngine engine(options.thread_count, seed, lambda);
+
+            // Сначала заполняем всю ёмкость: меряем установившийся режим, а не первое касание страниц
+            int step = 0;
+            for (; step < paths.capacity(); ++step) {
+                engine.step(particles);
+                paths.record(particles.x.data(), particles.y.data(), step);
+            }
+            // Шаги кратны текущему шагу записи: каждый вызов пишет кадр, иначе у
+            // PATH_STRIDE почти все вызовы пусты и замер не набирает время.
+            // Дальше MAX_STEPS прогон не идёт — там хранилище начинается заново, как при сбросе.
+            report(measure(path_case.name, n, 1, options.min_time, [&] {
+                paths.record(particles.x.data(), particles.y.data(), step);
+                step = (step / paths.stride() + 1) * paths.stride();
+                return static_cast<double>(n);
+            }, [&] {
+                engine.step(particles);
+                if (step > MAX_STEPS) {
+                    paths.clear();
+                    step = 0;
+                }
+            }));
+        }
+
+        // Старт: арена под весь бюджет и первый кадр, как в конструкторе SimulationRunner
+        if (wanted("path_configure")) {
+            ParticleEnsemble particles(n);
+            report(measure("path_configure", n, 1, options.min_time, [&] {
+                TrajectoryStore paths;
+                paths.configure(n, PATH_STRIDE, static_cast<size_t>(DEFAULT_PATH_BUDGET_MB) << 20, MAX_STEPS + 1);
+                paths.record(particles.x.data(), particles.y.data(), 0);
+                return static_cast<double>(n);
+            }));
+        }
+    }
+
+    print_footer(options);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#ifndef BOUNDARY_H
+#define BOUNDARY_H
+
+#include <cmath>
+#include "types.h"
+
+// === Граница области блуждания ===
+// Область с центром в начале координат: ящик со стороной size или круг
+// (в 1D — отрезок, в 3D — шар) радиуса size.
+typedef enum BoundaryKind {
+    BOUNDARY_NONE,       // бесконечная плоскость
+    BOUNDARY_PERIODIC,   // ящик, вышедшая частица входит с другой стороны
+    BOUNDARY_REFLECTING, // ящик с зеркальными стенками
+    BOUNDARY_ABSORBING,  // ящик, вышедшая частица выбывает из ансамбля
+    BOUNDARY_CIRCULAR    // круг с зеркальной стенкой
+} BoundaryKind;
+
+const int BOUNDARY_KIND_COUNT = 5;
+
+typedef struct Domain {
+    BoundaryKind kind;
+    float        size; // сторона ящика или радиус круга
+} Domain;
+
+Domain domain_from_settings(const Settings& settings);
+
+// Имя для вывода и разбора флага --boundary
+const char* boundary_name(BoundaryKind kind);
+// false, если имя не из списка none, periodic, reflecting, absorbing, circular
+bool parse_boundary(const char* name, BoundaryKind& kind);
+
+// ⟨r²⟩ равномерного распределения в области — предел, к которому выходит MSD
+// в ящике и круге; 0 для бесконечной плоскости и поглощающих стенок
+double equilibrium_r_squared(const Domain& domain, int dimension);
+
+// === Политики границы для ядра шага ===
+// Ядро шага — шаблон по политике, поэтому проверок вида «какая граница»
+// внутри блока нет, а у OpenBoundary apply() пустой и цикл остаётся прежним.
+// Политики с ABSORBS = false меняют координаты на месте через apply(),
+// с ABSORBS = true — только сообщают через inside(), осталась ли частица.
+// Оба вида без ветвлений: выбор делается арифметикой и тернарным select.
+
+// floor через усечение к int: без SSE4.1 std::floor — вызов функции и цикл не
+// векторизуется, а cvttps2dq есть в базовом SSE2. Верно при |v| < 2³¹.
+inline float floor_fast(float v) {
+    const float t = static_cast<float>(static_cast<int>(v));
+    return t - (t > v ? 1.0f : 0.0f);
+}
+
+struct OpenBoundary {
+    static const bool ABSORBS = false;
+    explicit OpenBoundary(float) {}
+
+    template <int D>
+    void apply(float&, float&, float&) const {}
+};
+
+// Свёртка в [-L/2, L/2) по каждой оси
+struct PeriodicBoundary {
+    static const bool ABSORBS = false;
+    float side, half, inv_side;
+
+    explicit PeriodicBoundary(float size) : side(size), half(0.5f * size), inv_side(1.0f / size) {}
+
+    float wrap(float v) const { return v - side * floor_fast((v + half) * inv_side); }
+
+    template <int D>
+    void apply(float& x, float& y, float& z) const {
+        x = wrap(x);
+        if constexpr (D >= 2)
+            y = wrap(y);
+        if constexpr (D == 3)
+            z = wrap(z);
+    }
+};
+
+// Зеркальное отражение — треугольная волна с периодом 2L: сколько бы раз
+// длинный шаг ни пересёк стенки, частица остаётся в [-L/2, L/2]
+struct ReflectingBoundary {
+    static const bool ABSORBS = false;
+    float side, half, inv_period;
+
+    explicit ReflectingBoundary(float size) : side(size), half(0.5f * size), inv_period(0.5f / size) {}
+
+    float fold(float v) const {
+        const float u = v + half;
+        const float m = u - 2.0f * side * floor_fast(u * inv_period);
+        return side - std::fabs(m - side) - half;
+    }
+
+    template <int D>
+    void apply(float& x, float& y, float& z) const {
+        x = fold(x);
+        if constexpr (D >= 2)
+            y = fold(y);
+        if constexpr (D == 3)
+            z = fold(z);
+    }
+};
+
+struct AbsorbingBoundary {
+    static const bool ABSORBS = true;
+    float half;
+
+    explicit AbsorbingBoundary(float size) : half(0.5f * size) {}
+
+    template <int D>
+    bool inside(float x, float y, float z) const {
+        bool in = std::fabs(x) < half;
+        if constexpr (D >= 2)
+            in = in & (std::fabs(y) < half);
+        if constexpr (D == 3)
+            in = in & (std::fabs(z) < half);
+        return in;
+    }
+};
+
+// Отражение по радиусу: r складывается той же треугольной волной с периодом 2R,
+// направление от центра сохраняется
+struct CircularBoundary {
+    static const bool ABSORBS = false;
+    float radius, radius_sq, inv_period;
+
+    explicit CircularBoundary(float size) : radius(size), radius_sq(size * size), inv_period(0.5f / size) {}
+
+    template <int D>
+    void apply(float& x, float& y, float& z) const {
+        float r_sq = x * x;
+        if constexpr (D >= 2)
+            r_sq += y * y;
+        if constexpr (D == 3)
+            r_sq += z * z;
+
+        const float r = std::sqrt(r_sq);
+        const float m = r - 2.0f * radius * floor_fast(r * inv_period);
+        const float folded = radius - std::fabs(m - radius);
+        const float scale = r_sq > radius_sq ? folded / r : 1.0f;
+        x *= scale;
+        if constexpr (D >= 2)
+            y *= scale;
+        if constexpr (D == 3)
+            z *= scale;
+    }
+};
+
+#endif // BOUNDARY_H
@@ -0,0 +1,69 @@
+#ifndef CHART_H
+#define CHART_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+// Подпись деления по его значению в единицах оси
+typedef std::string (*TickFormat)(float value);
+
+// === Ось графика: диапазон в единицах графика и число делений ===
+typedef struct ChartAxis {
+    float      min    = 0.0f;
+    float      max    = 1.0f;
+    int        ticks  = 10;
+    TickFormat format = nullptr;
+} ChartAxis;
+
+// === График с кэшированной разметкой ===
+// Оси, заголовок и подписи осей строятся один раз. Засечки и подписи делений
+// пересобираются только при смене масштаба, а кривые и отметки лежат в
+// готовых массивах вершин: каждая кривая — один sf::LineStrip, все отметки
+// поверх кривых — один sf::Lines. Надписи меняют строку, только если
+// изменился текст. Так график — пара десятков вызовов отрисовки за кадр.
+class Chart {
+public:
+    Chart(const sf::Font& font, const sf::FloatRect& area, const std::string& title,
+          const std::string& x_label, const std::string& y_label, int curve_count);
+
+    // Если диапазоны и число делений те же, подписи не трогаются
+    void set_axes(const ChartAxis& x, const ChartAxis& y);
+
+    // Кривая по точкам в единицах осей; count == 0 прячет кривую
+    void set_curve(int index, const float* xs, const float* ys, int count, sf::Color color);
+
+    // Отметки поверх кривых в единицах осей; clear_marks() — в начале обновления
+    void clear_marks();
+    void add_line(sf::Vector2f from, sf::Vector2f to, sf::Color color);
+    // Горизонтальный отрезок на уровне y со стрелками на обоих концах
+    void add_span(float x_from, float x_to, float y, sf::Color color);
+
+    // Надпись в координатах окна; пустой text прячет её
+    void set_note(int index, const std::string& text, sf::Vector2f position, unsigned size, sf::Color color);
+
+    void draw(sf::RenderTarget& target) const;
+
+    // Круглая граница оси не меньше value: 1, 2 или 5 на степень десяти
+    static float nice_ceiling(float value);
+
+private:
+    sf::Vector2f to_pixels(float x, float y) const;
+    void rebuild_ticks();
+
+    const sf::Font& font;
+    sf::FloatRect area;
+    ChartAxis x_axis;
+    ChartAxis y_axis;
+    bool has_axes = false;
+
+    sf::VertexArray frame;
+    std::vector<sf::Text> captions;
+    sf::VertexArray tick_marks;
+    std::vector<sf::Text> tick_labels;
+    std::vector<sf::VertexArray> curves;
+    sf::VertexArray marks;
+    std::vector<sf::Text> notes;
+};
+
+#endif // CHART_H
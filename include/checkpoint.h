@@ -0,0 +1,108 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "types.h"
+#include "ensemble.h"
+#include "moments.h"
+#include "sampler.h"
+#include "step_engine.h"
+
+// === Формат контрольной точки ===
+// [заголовок 96 байт][SamplerState * stream_count][x float32 * n][y float32 * n],
+// в 3D ещё [z float32 * n], затем [observables_bytes байт] — история моментов и
+// MSD(t). N в заголовке — исходное число частиц, n — сколько из них живо; при
+// поглощающих стенках n < N, иначе n = N.
+// Состояния генераторов сохраняются побитово, поэтому продолжение с контрольной
+// точки даёт те же координаты, что и прогон без остановки (при том же числе потоков).
+const char     CHECKPOINT_MAGIC[8] = {'B', 'M', 'C', 'K', 'P', 'T', '0', '1'};
+const uint32_t CHECKPOINT_VERSION  = 1;
+
+typedef struct CheckpointHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    int32_t  particle_count;
+    int32_t  mean_free_path;
+    int32_t  delay;
+    int32_t  thread_count;
+    uint32_t seed;
+    int32_t  steps_per_frame;
+    int32_t  path_policy;
+    int32_t  path_budget_mb;
+    int32_t  step;
+    uint32_t stream_count;
+    uint64_t checksum;       // FNV-1a по всему, что идёт после заголовка
+    int32_t  dimension;      // 1, 2 или 3; 0 — точка до 3D, считается 2D
+    int32_t  boundary;       // BoundaryKind; 0 — без границ, как и в старых точках
+    int32_t  domain_size;
+    int32_t  absorbed_count; // выбывших через поглощающие стенки; в старых точках 0
+    uint32_t observables_bytes; // 0 — точка без истории моментов и MSD(t)
+    uint8_t  padding[12];
+} CheckpointHeader;
+
+static_assert(sizeof(CheckpointHeader) == 96, "checkpoint header must stay 96 bytes");
+
+// === Полное состояние прогона ===
+struct Checkpoint {
+    Settings settings;
+    int step = 0;
+    std::vector<SamplerState> streams;
+    ParticleEnsemble particles;
+    // MomentHistory и MsdSeries, см. pack_observables(); пусто — в точке их нет
+    std::vector<uint8_t> observables;
+};
+
+// Производные ряды прогона в байты контрольной точки и обратно. Без них после
+// продолжения подгонка MSD(t) и история моментов начинались бы с шага продолжения.
+void pack_observables(const MomentHistory& history, const MsdSeries& msd, std::vector<uint8_t>& out);
+// false, если данных нет или они повреждены; history и msd тогда не определены
+bool unpack_observables(const std::vector<uint8_t>& data, MomentHistory& history, MsdSeries& msd);
+
+// Пишет во временный файл рядом и переименовывает: старая точка не портится при обрыве
+bool save_checkpoint(const char* path, const Checkpoint& checkpoint);
+bool load_checkpoint(const char* path, Checkpoint& checkpoint);
+
+// Только настройки из заголовка — чтобы построить окно и движок до загрузки координат
+bool load_checkpoint_settings(const char* path, Settings& settings);
+
+// === Периодическое сохранение в фоне ===
+// Поток симуляции только копирует состояние; запись на диск идёт в отдельном
+// потоке. Если прошлая запись ещё не закончилась, очередная точка пропускается,
+// чтобы медленный диск не тормозил шаги.
+class CheckpointWriter {
+public:
+    CheckpointWriter() = default;
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void configure(const char* path, int interval);
+    bool enabled() const { return !path.empty(); }
+    bool due(int step) const { return enabled() && interval > 0 && step > 0 && step % interval == 0; }
+
+    void save_async(const Settings& settings, int step, const StepEngine& engine, const ParticleEnsemble& particles,
+                    const MomentHistory& history, const MsdSeries& msd);
+
+    // Дожидается фоновой записи и сохраняет состояние сразу (при выходе)
+    void save_now(const Settings& settings, int step, const StepEngine& engine, const ParticleEnsemble& particles,
+                  const MomentHistory& history, const MsdSeries& msd);
+
+private:
+    void capture(const Settings& settings, int step, const StepEngine& engine, const ParticleEnsemble& particles,
+                 const MomentHistory& history, const MsdSeries& msd);
+    void wait();
+
+    std::string path;
+    int interval = 0;
+    Checkpoint pending;
+    std::thread worker;
+    std::atomic<bool> busy{false};
+};
+
+#endif // CHECKPOINT_H
@@ -9,6 +9,17 @@ extern const int   MAX_STEPS;
 extern const int   DEFAULT_PARTICLE_COUNT;
 extern const int   DEFAULT_STEP_SIZE;
 extern const int   DEFAULT_DELAY;
+extern const int   DEFAULT_DIMENSION;
+extern const int   MAX_DIMENSION;
+extern const int   DEFAULT_BOUNDARY;
+extern const int   DEFAULT_DOMAIN_SIZE;
+extern const int   MAX_THREAD_COUNT;
+extern const int   DEFAULT_STEPS_PER_FRAME;
+extern const int   DEFAULT_PATH_POLICY;
+extern const int   DEFAULT_PATH_BUDGET_MB;
+extern const int   DEFAULT_RECORD_STRIDE;
+extern const int   DEFAULT_CHECKPOINT_INTERVAL;
+extern const int   DEFAULT_FIT_INTERVAL;
 extern const float MOVE_CAMERA_FACTOR;
 extern const float ZOOM_IN_CAMERA_FACTOR;
 extern const float ZOOM_OUT_CAMERA_FACTOR;
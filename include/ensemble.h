@@ -0,0 +1,62 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Выравнивание массивов координат: одна кэш-линия, хватает и для AVX-512
+const std::size_t ENSEMBLE_ALIGNMENT = 64;
+
+// === Аллокатор с выравниванием для плоских массивов частиц ===
+template <typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ENSEMBLE_ALIGNMENT)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(ENSEMBLE_ALIGNMENT));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return false; }
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// === Ансамбль частиц в виде структуры массивов (SoA) ===
+// Траектории хранятся отдельно, см. TrajectoryStore. Массивы x и y есть
+// всегда (в 1D y остаётся нулевым), z заводится только в 3D.
+// Поглощающая граница уплотняет массивы: живы первые count частиц,
+// а размер массивов остаётся прежним до reset().
+struct ParticleEnsemble {
+    int count = 0;
+    int dimension = 2;
+    AlignedVector<float> x;
+    AlignedVector<float> y;
+    AlignedVector<float> z;
+
+    explicit ParticleEnsemble(int particle_count = 0, int dimension = 2);
+
+    // z или nullptr, если ансамбль не трёхмерный
+    const float* z_data() const { return dimension == 3 ? z.data() : nullptr; }
+
+    // Возвращает все частицы, и поглощённые тоже, в начало координат
+    void reset();
+};
+
+sf::Color particle_color(int index);
+
+#endif // ENSEMBLE_H
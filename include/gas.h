@@ -0,0 +1,87 @@
+#ifndef GAS_H
+#define GAS_H
+
+#include <vector>
+#include "ensemble.h"
+#include "moments.h"
+#include "sampler.h"
+
+// Средний пробег частицы за шаг в долях диаметра: чем меньше, тем реже
+// пара успевает проскочить друг сквозь друга за один шаг
+const float GAS_STEP_FRACTION = 0.1f;
+
+// === Газ твёрдых дисков в периодическом квадрате ===
+// Частицы летят по прямой и упруго сталкиваются; длина свободного пробега
+// получается из столкновений, а не задаётся распределением шага. Размер
+// ящика выбирается так, чтобы теория разреженного газа λ = 1 / (2√2 n d)
+// давала заданный mean_free_path, и измеренный ⟨λ⟩ с ней сравнивается.
+// При заметной плотности удары чаще в χ раз (поправка Энскога), см. enskog_chi().
+//
+// Соседи ищутся по сетке ячеек со стороной не меньше диаметра: частицы
+// раскладываются по ячейкам сортировкой подсчётом за O(N), пара проверяется
+// только в своей и соседних ячейках. Все массивы заводятся в configure(),
+// шаг ничего не выделяет.
+//
+// Координаты ансамбля — смещения от начальных точек без свёртки по ящику,
+// поэтому моменты и MSD(t) считают самодиффузию газа теми же средствами,
+// что и для блужданий. Свёрнутые координаты в ящике газ хранит сам.
+class HardDiskGas {
+public:
+    HardDiskGas() = default;
+
+    // Расставляет диски без перекрытий и разыгрывает скорости Максвелла.
+    // false и сообщение в stderr, если при такой плотности диски не помещаются.
+    bool configure(ParticleEnsemble& particles, float diameter, float mean_free_path, unsigned seed);
+
+    // Полёт на один шаг, пересборка сетки и столкновения
+    void step(ParticleEnsemble& particles);
+
+    // Моменты смещений после последнего step() — копятся в проходе полёта
+    EnsembleMoments moments(int step) const { return moments_from_sums(sums, count, 2, step); }
+
+    float     box_size() const { return box; }
+    float     diameter() const { return diameter_; }
+    long long collisions() const { return collisions_; }
+    // Средняя скорость в начале прогона; при упругих ударах энергия сохраняется
+    double    mean_speed() const { return mean_speed_; }
+    // Средняя длина завершённых пробегов; первый пробег каждой частицы не учитывается
+    double    measured_free_path() const { return flights > 0 ? flight_sum / flights : 0.0; }
+    long long flight_count() const { return flights; }
+    // Доля площади ящика, занятая дисками
+    double    packing_fraction() const { return packing_fraction_; }
+    // Парная корреляция на контакте для дисков: χ = (1 - 7φ/16) / (1 - φ)²
+    double    enskog_chi() const {
+        const double phi = packing_fraction_;
+        return (1.0 - 7.0 * phi / 16.0) / ((1.0 - phi) * (1.0 - phi));
+    }
+
+private:
+    void move(ParticleEnsemble& particles);
+    void build_cells();
+    void collide_cells(int a, int b);
+    void end_flight(int index);
+
+    int   count = 0;
+    int   steps = 0;
+    float box = 0.0f;
+    float diameter_ = 0.0f;
+    int   cells_per_side = 0;
+    float cell_size = 0.0f;
+
+    AlignedVector<float> box_x, box_y; // координаты в ящике [0, box)
+    AlignedVector<float> vx, vy;
+    std::vector<int>   cell_of;
+    std::vector<int>   cell_start;     // cell_start[c]..cell_start[c + 1] — частицы ячейки c в order
+    std::vector<int>   order;
+    std::vector<int>   last_collision; // шаг последнего удара, -1 — ударов ещё не было
+    std::vector<float> speed;          // скорость после последнего удара
+
+    MomentSums sums;
+    long long  collisions_ = 0;
+    long long  flights = 0;
+    double     flight_sum = 0.0;
+    double     mean_speed_ = 0.0;
+    double     packing_fraction_ = 0.0;
+};
+
+#endif // GAS_H
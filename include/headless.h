@@ -0,0 +1,30 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <string>
+#include "types.h"
+
+typedef struct HeadlessOptions {
+    Settings    settings;
+    int         steps;
+    std::string output_path;  // пусто — печать в stdout
+    std::string moments_path; // ряд моментов по шагам (--moments), пусто — не писать
+    std::string fit_path;     // KS и χ² против χ-распределения по шагам (--fit-log), пусто — не писать
+    int         fit_interval; // шагов между замерами согласия (--fit-every)
+    double      stop_ks;      // остановка, когда KS не больше этого (--stop-ks), 0 — до конца
+    double      gas_diameter; // газ твёрдых дисков такого диаметра (--gas), 0 — независимые блуждания
+    OutputOptions output;     // запись траекторий (--record, --record-every)
+} HeadlessOptions;
+
+// Разбирает аргументы вида --headless -n N -l L -s STEPS [-d DIM] --seed S [-j T] [-t T] [-o FILE]
+// [--record FILE] [--record-every K] [--moments FILE] [--fit-log FILE] [--fit-every K] [--stop-ks D]
+// [--gas DIAMETER] [--boundary KIND] [--domain SIZE].
+// Возвращает false и печатает подсказку в stderr при ошибке.
+bool parse_headless_args(int argc, char** argv, HeadlessOptions& options);
+
+void print_headless_usage(const char* program);
+
+// Прогон без окна: шаги идут без ограничения кадров, итог пишется в файл или stdout
+int run_headless(const HeadlessOptions& options);
+
+#endif // HEADLESS_H
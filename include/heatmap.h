@@ -0,0 +1,67 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+#include "ensemble.h"
+#include "worker_pool.h"
+
+// Размер клетки карты плотности в пикселях окна
+const int HEATMAP_CELL_PX = 2;
+// Сторона мировой сетки накопленных посещений
+const int VISIT_GRID_SIZE = 1024;
+
+// === Сетка занятости с параллельным накоплением ===
+struct OccupancyGrid {
+    int width = 0;
+    int height = 0;
+    sf::FloatRect bounds;         // прямоугольник мира, который покрывает сетка
+    std::vector<uint32_t> counts;
+    uint32_t max_count = 0;
+};
+
+// === Режим отрисовки плотности для больших ансамблей ===
+// Частицы раскладываются по клеткам в несколько потоков (у каждого своя
+// частичная сетка, затем сумма по строкам), сетка раскрашивается палитрой
+// и рисуется одной текстурой. Стоимость отрисовки зависит от числа
+// пикселей, а не от числа частиц и длины траекторий.
+//
+// Пул потоков чужой — обычно это пул движка шага. Частичные сетки живут
+// между вызовами и обнуляются тем же проходом, что их суммирует, поэтому
+// кадр не выделяет память и не чистит сетки отдельно.
+class DensityHeatmap {
+public:
+    // pool должен пережить карту
+    DensityHeatmap(WorkerPool& pool, float world_half_size);
+
+    // Мгновенная плотность в пределах камеры
+    void draw_density(sf::RenderTarget& target, const ParticleEnsemble& particles, const sf::View& camera);
+
+    // Накопленная по снимкам карта посещений в фиксированной области мира.
+    // Вызывающий решает, когда копить: окно делает это, только пока карта на экране.
+    void accumulate_visits(const ParticleEnsemble& particles);
+    void clear_visits();
+    void draw_visits(sf::RenderTarget& target);
+
+private:
+    // accumulate = true прибавляет к grid.counts, иначе перезаписывает их
+    void bin(const ParticleEnsemble& particles, OccupancyGrid& grid, bool accumulate);
+    void colorize(const OccupancyGrid& grid, sf::Texture& texture);
+    void draw_grid(sf::RenderTarget& target, const OccupancyGrid& grid, sf::Texture& texture);
+
+    WorkerPool& pool;
+    std::vector<std::vector<uint32_t>> partials; // между вызовами целиком нулевые
+    std::vector<uint32_t> chunk_max;
+
+    OccupancyGrid density;
+    sf::Texture density_texture;
+
+    OccupancyGrid visits;
+    sf::Texture visits_texture;
+
+    std::vector<sf::Uint8> pixels;
+    sf::Color palette[256];
+};
+
+#endif // HEATMAP_H
@@ -0,0 +1,137 @@
+#ifndef MOMENTS_H
+#define MOMENTS_H
+
+#include <cstdint>
+#include <vector>
+#include "ensemble.h"
+
+// Сколько независимых сумм ведёт ядро шага внутри блока (цепочки сложений не ждут друг друга)
+const int MOMENT_LANES = 4;
+// Сколько частиц складывается в double, прежде чем сумма уходит в накопитель Кэхэна
+const int MOMENT_BLOCK = 1024;
+// Сколько точек истории моментов хранится; дальше история прореживается
+const int MOMENT_HISTORY_CAPACITY = 1 << 16;
+// Кольцо точек MSD(t) и множитель шага между соседними точками (логарифмическая сетка)
+const int    MSD_RING_CAPACITY = 1024;
+const double MSD_LOG_RATIO     = 1.01;
+
+// === Суммы по куску ансамбля ===
+// Внутри блока частицы складываются в double по MOMENT_LANES дорожкам,
+// суммы блоков копятся с компенсацией Кэхэна. Куски складываются между
+// собой в порядке номеров, поэтому результат не зависит от планировщика.
+// Суммы по осям, которых у ансамбля нет, остаются нулевыми.
+struct MomentSums {
+    double x = 0.0, y = 0.0, z = 0.0, xx = 0.0, yy = 0.0, zz = 0.0, r4 = 0.0;
+    double cx = 0.0, cy = 0.0, cz = 0.0, cxx = 0.0, cyy = 0.0, czz = 0.0, cr4 = 0.0; // поправки Кэхэна
+
+    // Частичные суммы блока по дорожкам
+    void add_block(const double* bx, const double* by, const double* bz,
+                   const double* bxx, const double* byy, const double* bzz, const double* br4);
+    void add(const MomentSums& other);
+};
+
+// === Моменты ансамбля на одном шаге ===
+struct EnsembleMoments {
+    int    step = 0;
+    int    count = 0;
+    int    dimension = 2;
+    double mean_x = 0.0;
+    double mean_y = 0.0;
+    double mean_z = 0.0;
+    double var_x = 0.0;
+    double var_y = 0.0;
+    double var_z = 0.0;
+    double mean_r_squared = 0.0; // ⟨r²⟩ — MSD от начала координат
+    double mean_r_fourth = 0.0;  // ⟨r⁴⟩
+
+    // Негауссов параметр α₂ = d⟨r⁴⟩ / ((d + 2)⟨r²⟩²) - 1; для гауссова облака в d измерениях равен 0
+    double non_gaussian() const {
+        return mean_r_squared > 0.0
+            ? dimension * mean_r_fourth / ((dimension + 2) * mean_r_squared * mean_r_squared) - 1.0
+            : 0.0;
+    }
+};
+
+EnsembleMoments moments_from_sums(const MomentSums& sums, int count, int dimension, int step);
+
+// Отдельный проход по ансамблю — для начального состояния и записанных кадров
+EnsembleMoments measure_moments(const ParticleEnsemble& particles, int step);
+
+// Добавляет в sums один блок из n частиц (n <= MOMENT_BLOCK) в D измерениях;
+// z читается только при D == 3. Ядро шага зовёт его сразу после сдвига блока,
+// пока координаты ещё в L1.
+template <int D>
+void accumulate_block(const float* x, const float* y, const float* z, int n, MomentSums& sums);
+
+// Суммы по частицам [begin, end) теми же блоками, что и в ядре шага
+void accumulate_moments(const ParticleEnsemble& particles, int begin, int end, MomentSums& sums);
+
+// === История моментов за весь прогон ===
+// Не больше MOMENT_HISTORY_CAPACITY точек: при заполнении выбрасывается
+// каждая вторая и шаг записи удваивается, как у траекторий PATH_STRIDE.
+class MomentHistory {
+public:
+    MomentHistory();
+
+    void clear();
+    void record(const EnsembleMoments& moments);
+
+    int size() const { return static_cast<int>(points.size()); }
+    int stride() const { return stride_; }
+    const EnsembleMoments& at(int index) const { return points[index]; }
+
+    // Побайтовый снимок для контрольной точки; load() двигает data за прочитанное
+    // и возвращает false, если данных не хватает или они не похожи на историю
+    void save(std::vector<uint8_t>& out) const;
+    bool load(const uint8_t*& data, const uint8_t* end);
+
+private:
+    std::vector<EnsembleMoments> points;
+    int stride_ = 1;
+};
+
+struct MsdPoint {
+    int    step;
+    double msd;
+};
+
+// === MSD(t) на логарифмической сетке с подгонкой ⟨r²⟩ = 2d D t^α ===
+// Точка берётся, когда шаг доходит до следующей отметки сетки: первые ~100
+// шагов подряд, дальше через MSD_LOG_RATIO. Так кольцо из MSD_RING_CAPACITY
+// точек покрывает около шести декад, а каждая декада весит в подгонке одинаково.
+// Суммы для метода наименьших квадратов по (ln t, ln ⟨r²⟩) обновляются при
+// добавлении и вытеснении точки — O(1) на шаг; раз в оборот кольца они
+// пересчитываются заново, чтобы не копилась ошибка вычитания.
+class MsdSeries {
+public:
+    MsdSeries();
+
+    void clear();
+    void record(int step, double msd);
+
+    int size() const { return count; }
+    // 0 — самая ранняя точка в кольце
+    const MsdPoint& at(int index) const { return ring[(head + index) % MSD_RING_CAPACITY]; }
+
+    // α и D по точкам в кольце; время шага delay переводит шаги во время,
+    // dimension — число измерений d. Возвращает false, если точек меньше двух.
+    bool fit(double delay, int dimension, double& alpha, double& diffusion) const;
+
+    // Снимок для контрольной точки: точки кольца по порядку, отметка сетки и
+    // накопленные суммы как есть, чтобы продолженная подгонка совпала побитово
+    void save(std::vector<uint8_t>& out) const;
+    bool load(const uint8_t*& data, const uint8_t* end);
+
+private:
+    void add_sums(const MsdPoint& point, double sign);
+    void rebuild_sums();
+
+    std::vector<MsdPoint> ring;
+    int head = 0;
+    int count = 0;
+    int next_step = 1;
+    int since_rebuild = 0;
+    double sum_t = 0.0, sum_m = 0.0, sum_tt = 0.0, sum_tm = 0.0;
+};
+
+#endif // MOMENTS_H
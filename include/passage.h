@@ -0,0 +1,105 @@
+#ifndef PASSAGE_H
+#define PASSAGE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "boundary.h"
+
+// Сколько радиусов следит монитор: по биту на радиус в маске частицы
+const int MAX_PASSAGE_RADII = 8;
+// Ряды гистограмм: радиусы и, при поглощающих стенках, сама стенка
+const int MAX_PASSAGE_TARGETS = MAX_PASSAGE_RADII + 1;
+// Столбцов в гистограмме времён; ширина столбца подбирается под длину прогона
+const int PASSAGE_BINS = 200;
+// Частиц на один проход observe(): столько |r|² лежит на стеке
+const int PASSAGE_BLOCK = 256;
+// Счётчики куска занимают целую кэш-линию, чтобы потоки не делили строку
+const int PASSAGE_COUNTER_STRIDE = 16;
+
+// === Времена первого достижения радиусов ===
+// Ядро шага после сдвига блока зовёт observe(): |r|² сравнивается с R² без
+// корня, новые пересечения отмечаются в битовой маске частицы и считаются
+// в счётчиках куска. После шага record_step() переносит счётчики кусков в
+// гистограммы, поэтому траектории для этого не нужны.
+//
+// Проверка идёт раз за шаг: пересечение внутри шага с возвратом обратно не
+// видно, и на радиусах порядка длины пробега времена чуть больше теории
+// непрерывной диффузии. Частицы стартуют из начала координат.
+//
+// Поглощающая стенка — отдельный ряд: время выхода из ящика — это шаг,
+// на котором частица выбыла, его видно по убыли particles.count. Частица,
+// выбывшая на том же шаге, что перескочила радиус, радиус не засчитывает.
+class PassageMonitor {
+public:
+    PassageMonitor() = default;
+
+    // radii сортируются по возрастанию, лишние сверх MAX_PASSAGE_RADII отбрасываются.
+    // domain нужен для ряда стенки и теории; max_steps задаёт ширину столбца.
+    void configure(const std::vector<float>& radii, const Domain& domain, int dimension, float mean_free_path,
+                   int particle_count, int chunk_count, int max_steps);
+    bool enabled() const { return target_count_ > 0; }
+
+    // Все частицы снова внутри всех радиусов, гистограммы пусты
+    void reset();
+
+    // Вызывается из ядра шага для частиц [first, first + n) куска chunk
+    template <int D>
+    void observe(int chunk, const float* x, const float* y, const float* z, int first, int n);
+
+    // Маска частиц; поглощение уплотняет её вместе с координатами
+    uint32_t* mask_data() { return mask.data(); }
+
+    // Переносит пересечения последнего шага в гистограммы; absorbed — сколько частиц выбыло за шаг
+    void record_step(int step, int absorbed);
+
+    int   target_count() const { return target_count_; }
+    bool  is_wall(int target) const { return target == radius_count; }
+    float radius(int target) const { return is_wall(target) ? 0.0f : radii_[target]; }
+    std::string target_name(int target) const;
+
+    int bin_steps() const { return bin_steps_; }
+    // Столбцы до последнего записанного шага включительно
+    int bins_used() const { return last_step > 0 ? std::min(PASSAGE_BINS, (last_step - 1) / bin_steps_ + 1) : 0; }
+    long long bin_count(int target, int bin) const { return histogram[target * PASSAGE_BINS + bin]; }
+
+    long long crossed(int target) const { return crossed_[target]; }
+    // Среднее время среди уже дошедших частиц; пока дошли не все, оно занижено
+    double mean_time(int target) const { return crossed_[target] > 0 ? time_sum[target] / crossed_[target] : 0.0; }
+    // Доля частиц, дошедших к шагу step, и то же по теории диффузии с D = λ²/d на шаг
+    double empirical_cdf(int target, int bin) const;
+    double theory_cdf(int target, double step) const;
+    // Среднее время по теории: R² / 2λ² для радиуса, сумма выживания для ящика
+    double theory_mean(int target) const;
+    // Наибольшее расхождение эмпирической и теоретической CDF по концам столбцов
+    double ks_distance(int target) const;
+
+private:
+    double survival(int target, double step) const;
+
+    int count = 0;
+    int radius_count = 0;
+    int target_count_ = 0;
+    int bin_steps_ = 1;
+    int last_step = 0;
+    float radii_[MAX_PASSAGE_RADII] = {};
+    float radius_sq[MAX_PASSAGE_RADII] = {};
+
+    std::vector<uint32_t>  mask;
+    std::vector<int>       chunk_counts;  // PASSAGE_COUNTER_STRIDE на кусок
+    std::vector<long long> histogram;     // PASSAGE_BINS на ряд
+    long long crossed_[MAX_PASSAGE_TARGETS] = {};
+    double    time_sum[MAX_PASSAGE_TARGETS] = {};
+
+    // Выживание S(t) = (Σ cₙ e^{-aₙ t})^power: шар из центра — power = 1,
+    // ящик — произведение d независимых отрезков, power = d
+    std::vector<double> coefficients[MAX_PASSAGE_TARGETS];
+    std::vector<double> rates[MAX_PASSAGE_TARGETS];
+    int power[MAX_PASSAGE_TARGETS] = {};
+};
+
+// Радиусы через запятую: "50,100,200"; false, если список пуст или в нём не положительное число
+bool parse_passage_radii(const char* text, std::vector<float>& radii);
+
+#endif // PASSAGE_H
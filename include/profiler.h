@@ -0,0 +1,143 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// === Фазы кадра, которые меряет профилировщик ===
+typedef enum ProfilePhase {
+    PROFILE_FRAME,     // весь кадр целиком
+    PROFILE_EVENTS,    // разбор событий окна
+    PROFILE_SNAPSHOT,  // бюджет шагов и забор снимка у потока симуляции
+    PROFILE_STEP,      // шаги в потоке симуляции с прошлого кадра (сумма)
+    PROFILE_STATS,     // гистограмма, CDF/PDF, D
+    PROFILE_GRID,      // сетка и оси
+    PROFILE_PATHS,     // траектории
+    PROFILE_PARTICLES, // точки частиц
+    PROFILE_HEATMAP,   // карты плотности и посещений
+    PROFILE_PLOT,      // отрисовка графика CDF/PDF
+    PROFILE_HUD,       // круг, подписи, подсказки и сам оверлей
+    PROFILE_DISPLAY,   // window.display(), включая ожидание vsync
+    PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+const char* profile_phase_name(ProfilePhase phase);
+
+// Сколько последних кадров учитывается в скользящих средних и p99
+const int PROFILE_WINDOW = 240;
+
+// === Файл покадровых замеров ===
+// Открывается один раз в main и переживает выходы в меню: каждый прогон
+// окна — новая сессия. В CSV номер сессии — первая колонка, в Chrome trace
+// у сессии свой pid с именем "session N". Время в trace отсчитывается от
+// открытия файла, поэтому сессии идут друг за другом.
+class ProfileDump {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    ProfileDump() : origin_(Clock::now()) {}
+    ~ProfileDump();
+
+    ProfileDump(const ProfileDump&) = delete;
+    ProfileDump& operator=(const ProfileDump&) = delete;
+
+    // Формат выбирается по расширению: .json — trace, иначе CSV
+    bool open(const char* path);
+    // Номер новой сессии, начиная с 1
+    int begin_session();
+
+    FILE* file() const { return file_; }
+    bool  trace() const { return trace_; }
+    Clock::time_point origin() const { return origin_; }
+    // Разделитель перед очередным событием trace
+    const char* separator();
+
+private:
+    FILE* file_ = nullptr;
+    bool  trace_ = false;
+    bool  first = true;
+    int   sessions = 0;
+    Clock::time_point origin_;
+};
+
+// === Профилировщик кадров ===
+// Хранит длительности фаз за последние PROFILE_WINDOW кадров в кольце,
+// по запросу считает среднее и 99-й перцентиль. Если подключён файл выгрузки,
+// в конце каждого кадра пишет в него строку CSV или события Chrome trace.
+class FrameProfiler {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    FrameProfiler();
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    // Подключает файл замеров и открывает в нём новую сессию; nullptr — без выгрузки
+    void attach_dump(ProfileDump* dump);
+
+    void begin_frame();
+    void end_frame();
+
+    // Фаза [start, start + seconds) текущего кадра; повторы внутри кадра суммируются
+    void add(ProfilePhase phase, Clock::time_point start, double seconds);
+    // Фаза, измеренная в другом потоке: известна только длительность
+    void add(ProfilePhase phase, double seconds);
+
+    double average_ms(ProfilePhase phase) const;
+    double p99_ms(ProfilePhase phase) const;
+
+    void draw_overlay(sf::RenderTarget& target, const sf::Font& font, sf::Vector2f position, sf::Color color);
+
+private:
+    struct TraceEvent {
+        ProfilePhase phase;
+        double start_us;
+        double duration_us;
+    };
+
+    void write_dump();
+
+    Clock::time_point origin;
+    Clock::time_point frame_start;
+    long long frame_index = 0;
+
+    double current[PROFILE_PHASE_COUNT];
+    std::vector<TraceEvent> events;
+
+    std::vector<float> history[PROFILE_PHASE_COUNT]; // мс, кольцо на PROFILE_WINDOW кадров
+    int filled = 0;
+    int cursor = 0;
+
+    ProfileDump* dump = nullptr;
+    int session = 0;
+
+    mutable std::vector<float> scratch;
+    sf::Text overlay;
+    std::string overlay_string;
+};
+
+// === Замер области видимости ===
+class ScopedTimer {
+public:
+    ScopedTimer(FrameProfiler& profiler, ProfilePhase phase)
+        : profiler(profiler), phase(phase), start(FrameProfiler::Clock::now()) {}
+
+    ~ScopedTimer() {
+        const double seconds = std::chrono::duration<double>(FrameProfiler::Clock::now() - start).count();
+        profiler.add(phase, start, seconds);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    FrameProfiler& profiler;
+    ProfilePhase phase;
+    FrameProfiler::Clock::time_point start;
+};
+
+#endif // PROFILER_H
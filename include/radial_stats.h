@@ -0,0 +1,44 @@
+#ifndef RADIAL_STATS_H
+#define RADIAL_STATS_H
+
+#include <vector>
+
+// Число мелких бинов по r²; графики собирают из них свои 100 точек
+const int RADIAL_FINE_BINS = 4096;
+
+// === Радиальная гистограмма за O(N) без сортировки и без sqrt ===
+// Квадраты расстояний раскладываются по равным бинам на [0, max r²],
+// дальше накопленные счётчики дают число частиц внутри любого радиуса за O(1).
+struct RadialHistogram {
+    int    total = 0;
+    float  max_r_squared = 0.0f;
+    std::vector<int> cumulative; // cumulative[i] — частиц с r² < (i + 1) * ширина бина
+
+    // z == nullptr — ансамбль не трёхмерный (в 1D y нулевой и на r² не влияет)
+    void build(const float* x, const float* y, const float* z, int count);
+
+    float max_radius() const;
+
+    // Число частиц с расстоянием не больше r (линейно внутри бина)
+    float count_within(float r) const;
+};
+
+// === Теория: расстояние от начала — χ-распределение с d степенями свободы ===
+// Каждая ось — N(0, σ²) с σ² = 2λ²n / d, поэтому |r| / σ ~ χ_d:
+// в 1D это полунормальное распределение, в 2D — Рэлей, в 3D — Максвелл.
+double chi_cdf(int dimension, double r, double sigma_sq);
+double chi_pdf(int dimension, double r, double sigma_sq);
+
+// === Согласие с χ-распределением ===
+// Считается по бинам гистограммы за O(бинов), без сортировки частиц.
+typedef struct GoodnessOfFit {
+    double ks;    // расстояние Колмогорова–Смирнова по границам бинов
+    double ks_p;  // асимптотическое p-значение для ks
+    double chi2;  // χ² по бинам, слитым до ожидаемых ≥ 5 частиц
+    int    dof;   // число степеней свободы χ²; 0 — сравнивать не с чем (нет частиц)
+} GoodnessOfFit;
+
+// Сравнение с chi_cdf(dimension, r, σ²); в 2D — с CDF Рэлея F(r) = 1 - exp(-r² / 2σ²)
+GoodnessOfFit chi_goodness(const RadialHistogram& histogram, int dimension, double sigma_sq);
+
+#endif // RADIAL_STATS_H
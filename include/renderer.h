@@ -0,0 +1,72 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "ensemble.h"
+#include "trajectory.h"
+
+// Предел вершин буфера траекторий (~80 МБ). Рисуются пути всех частиц: если
+// все точки не помещаются, отрезок соединяет каждую k-ю точку хранилища
+const int MAX_PATH_VERTICES = 4 * 1024 * 1024;
+
+// Направления осей x и y в изометрии: ±30° к горизонтали экрана
+const float ISO_COS = 0.8660254f;
+const float ISO_SIN = 0.5f;
+
+// === Проекция частиц на экран ===
+typedef enum Projection {
+    PROJECTION_TOP,      // вид сверху: (x, y), z отбрасывается
+    PROJECTION_ISOMETRIC // изометрия: z вверх, плоскость xy — ромбом
+} Projection;
+
+// Точка пространства на экране в изометрии (ось y экрана SFML смотрит вниз)
+inline sf::Vector2f isometric(float x, float y, float z) {
+    return sf::Vector2f((x - y) * ISO_COS, (x + y) * ISO_SIN - z);
+}
+
+// === Пакетная отрисовка частиц и траекторий ===
+// Все точки — один массив sf::Quads, все траектории — один буфер sf::Lines,
+// который живёт на видеокарте и дописывается только новыми отрезками.
+// Отрезки лежат по ячейкам буфера: [ячейка][частица], поэтому одна
+// новая точка всех частиц — это один непрерывный кусок буфера.
+//
+// Отрезок k соединяет точки с номерами (k - 1)·step и k·step (номера — по
+// счёту записанных точек, см. TrajectoryStore::stored()), обрезанные окном
+// хранимых точек; последний отрезок тянется до самой свежей точки. Ячеек
+// по кольцу ровно столько, чтобы вместить все отрезки окна. При step = 1
+// это прежняя картина без прореживания. Если даже при step, равном ёмкости,
+// N частиц не помещаются в MAX_PATH_VERTICES, траектории не рисуются.
+class ParticleRenderer {
+public:
+    ParticleRenderer();
+
+    void draw_particles(sf::RenderTarget& target, const ParticleEnsemble& particles,
+                        float radius, sf::Color color, Projection projection = PROJECTION_TOP);
+
+    // Вызывать под мьютексом траекторий. Хранилище держит только (x, y),
+    // поэтому траектории рисуются в проекции сверху.
+    void draw_paths(sf::RenderTarget& target, const TrajectoryStore& paths);
+
+private:
+    void rebuild_paths(const TrajectoryStore& paths);
+    // Пишет отрезок k в его ячейку и возвращает её номер
+    int  write_segment(const TrajectoryStore& paths, long long k);
+    void clear_segment(int cell);
+    void upload_segment(int cell);
+
+    sf::VertexArray dots;
+
+    bool use_buffer;
+    sf::VertexBuffer path_buffer;
+    std::vector<sf::Vertex> path_vertices; // копия буфера в памяти
+    int path_particles = 0;
+    int path_capacity = 0;
+    int path_step = 1;  // точек хранилища на отрезок
+    int path_cells = 0; // ячеек в кольце отрезков
+    unsigned seen_revision = 0;
+    long long seen_stored = -1;
+    long long seen_first = 0; // номер старейшей хранимой точки при прошлом кадре
+};
+
+#endif // RENDERER_H
@@ -0,0 +1,111 @@
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "types.h"
+#include "ensemble.h"
+#include "step_engine.h"
+#include "moments.h"
+#include "passage.h"
+#include "trajectory.h"
+#include "trajectory_writer.h"
+#include "checkpoint.h"
+
+// === Снимок состояния, который видит поток отрисовки ===
+struct Snapshot {
+    int step = 0;
+    ParticleEnsemble particles;
+    EnsembleMoments moments;
+};
+
+// === Поток симуляции, отвязанный от кадров ===
+// Шаги считаются в отдельном потоке и публикуются через тройной буфер:
+// писатель и читатель никогда не ждут друг друга, а окно всегда рисует
+// самый свежий готовый снимок.
+class SimulationRunner {
+public:
+    // Если в output задан trajectory_path, кадры пишутся в файл каждые trajectory_stride шагов.
+    // checkpoint_path — контрольные точки каждые checkpoint_interval шагов и при закрытии,
+    // resume_path — начать с сохранённого состояния вместо нуля.
+    SimulationRunner(const Settings& settings, const OutputOptions& output);
+    ~SimulationRunner();
+
+    SimulationRunner(const SimulationRunner&) = delete;
+    SimulationRunner& operator=(const SimulationRunner&) = delete;
+
+    // Вызывается раз в кадр: разрешает ещё steps_per_frame шагов
+    void grant_frame();
+
+    // 0 — считать без ограничений, иначе столько шагов на кадр
+    void set_steps_per_frame(int steps);
+    int  steps_per_frame() const { return steps_per_frame_.load(); }
+
+    void set_paused(bool paused);
+    bool paused() const { return paused_.load(); }
+    void request_reset();
+
+    // Последний опубликованный снимок; действителен до следующего вызова
+    const Snapshot& latest();
+
+    // Траектории дописывает поток симуляции, читать их можно только под этим мьютексом
+    std::mutex& paths_mutex() { return paths_mutex_; }
+    const TrajectoryStore& trajectories() const { return paths; }
+
+    // Ряд моментов по шагам и MSD(t) для подгонки — тоже только под своим мьютексом
+    std::mutex& history_mutex() { return history_mutex_; }
+    const MomentHistory& moment_history() const { return history; }
+    const MsdSeries& msd_series() const { return msd; }
+    // Гистограммы первого достижения; disabled, если --passage не задан
+    const PassageMonitor& passage_monitor() const { return passage; }
+
+    // Пул потоков движка — окну, чтобы его параллельная работа не шла поверх шагов
+    WorkerPool& worker_pool() { return engine.worker_pool(); }
+
+    // Время шагов (с записью траекторий) с прошлого вызова — для профилировщика
+    double take_step_seconds() { return step_ns.exchange(0) * 1e-9; }
+
+private:
+    void loop();
+    void publish();
+    bool can_step() const;
+
+    Settings settings;
+    ParticleEnsemble particles;
+    TrajectoryStore paths;
+    EnsembleMoments moments;
+    MomentHistory history;
+    MsdSeries msd;
+    PassageMonitor passage;
+    TrajectoryWriter writer;
+    CheckpointWriter checkpoints;
+    StepEngine engine;
+    int current_step = 0;
+    // Шаг, на котором прогон начат или сохранён: выход без новых шагов не пишет точку
+    int checkpoint_step = 0;
+
+    // Тройной буфер: индекс среднего буфера плюс флаг «есть свежий снимок»
+    static const int SNAPSHOT_FRESH = 4;
+    Snapshot buffers[3];
+    int write_index = 0;
+    int read_index  = 2;
+    std::atomic<int> middle{1};
+
+    std::mutex paths_mutex_;
+    std::mutex history_mutex_;
+
+    std::mutex control_mutex;
+    std::condition_variable control_cv;
+    std::atomic<int>  steps_per_frame_;
+    std::atomic<bool> paused_{false};
+    std::atomic<bool> reset_requested{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<long long> step_ns{0};
+    int frame_budget = 0;
+
+    std::thread worker;
+};
+
+#endif // RUNNER_H
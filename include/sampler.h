@@ -0,0 +1,45 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// === Набор инструкций, которым считаются выборки ===
+typedef enum SamplerIsa {
+    SAMPLER_SCALAR,
+    SAMPLER_SSE2,
+    SAMPLER_AVX2
+} SamplerIsa;
+
+SamplerIsa  detect_sampler_isa();
+const char* sampler_isa_name(SamplerIsa isa);
+
+// Число независимых дорожек xoshiro128+ (ширина одного AVX2-регистра)
+const int SAMPLER_LANES = 8;
+
+struct alignas(32) SamplerState {
+    uint32_t s[4][SAMPLER_LANES];
+};
+
+// === Пакетный генератор экспоненциальных и нормальных величин ===
+// Восемь дорожек xoshiro128+ дают равномерные числа, нормальные получаются
+// преобразованием Бокса–Мюллера, экспоненциальные — как -mean * ln(u).
+// Скалярная, SSE2 и AVX2 ветки выполняют одни и те же операции в одном
+// порядке, поэтому выдают побитово одинаковые значения на любой машине.
+class BatchSampler {
+public:
+    explicit BatchSampler(SamplerIsa isa = detect_sampler_isa());
+
+    void seed(uint64_t seed, uint64_t stream);
+
+    // n значений Exp со средним mean
+    void fill_exponential(float* out, size_t n, float mean);
+
+    // n пар независимых N(0, 1)
+    void fill_gaussian(float* a, float* b, size_t n);
+
+    SamplerIsa   isa;
+    SamplerState state;
+};
+
+#endif // SAMPLER_H
@@ -4,6 +4,10 @@
 #include <SFML/Graphics.hpp>
 #include "types.h"
 
-void run_simulation(sf::RenderWindow& window, sf::Font& font, Settings settings);
+void run_simulation(sf::RenderWindow& window, sf::Font& font, Settings settings, const OutputOptions& output);
+
+// Просмотр записанного файла траекторий теми же видами; -1, если файл не открылся
+int run_replay(sf::RenderWindow& window, sf::Font& font, Settings settings,
+               const char* path, const OutputOptions& output);
 
 #endif // SIMULATION_H
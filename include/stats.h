@@ -0,0 +1,70 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <vector>
+#include "ensemble.h"
+#include "radial_stats.h"
+#include "moments.h"
+
+// Сколько точек у кривых CDF/PDF
+const int CURVE_POINT_COUNT = 100;
+
+// === Кривая против радиуса: эксперимент и χ-теория в одних точках ===
+struct RadialCurve {
+    float max_radius = 0.0f;
+    std::vector<float> radii;
+    std::vector<float> empirical;
+    std::vector<float> theory;
+};
+
+// === Статистика одного снимка, считаемая по требованию ===
+// Снимок привязывается через bind(); величины считаются только при первом
+// запросе и кэшируются до следующего снимка. Так каждая величина считается
+// не чаще раза за кадр и только если её показывает активный вид. Моменты
+// (⟨r²⟩, D, α₂) приходят готовыми из ядра шага и прохода не требуют.
+class EnsembleStats {
+public:
+    EnsembleStats() = default;
+
+    // Новый снимок. Если шаг тот же, что и в прошлый раз, кэш сохраняется.
+    void bind(const ParticleEnsemble& particles, const EnsembleMoments& moments, float mean_free_path, int delay);
+
+    int   step() const { return moments_.step; }
+    int   dimension() const { return moments_.dimension; }
+    float mean_free_path() const { return mean_free_path_; }
+
+    // σ² = 2λ² * N / d — дисперсия по одной оси, параметр χ-распределения (в 2D — Рэлея)
+    float sigma_squared() const;
+
+    const RadialHistogram& histogram();
+    const RadialCurve&     cdf();
+    const RadialCurve&     pdf();
+    // KS и χ² против χ-распределения с σ² = 2λ² * N / d — по бинам гистограммы
+    const GoodnessOfFit&   goodness();
+    const EnsembleMoments& moments() const { return moments_; }
+    float mean_r_squared() const { return static_cast<float>(moments_.mean_r_squared); }
+    float rms_radius() const;
+    float diffusion_coefficient() const;
+
+private:
+    enum DirtyFlag {
+        DIRTY_HISTOGRAM = 1 << 0,
+        DIRTY_CDF       = 1 << 1,
+        DIRTY_PDF       = 1 << 2,
+        DIRTY_FIT       = 1 << 3,
+        DIRTY_ALL       = DIRTY_HISTOGRAM | DIRTY_CDF | DIRTY_PDF | DIRTY_FIT
+    };
+
+    const ParticleEnsemble* particles = nullptr;
+    EnsembleMoments moments_;
+    float mean_free_path_ = 0.0f;
+    int   delay = 1;
+    unsigned dirty = DIRTY_ALL;
+
+    RadialHistogram histogram_;
+    RadialCurve cdf_;
+    RadialCurve pdf_;
+    GoodnessOfFit goodness_;
+};
+
+#endif // STATS_H
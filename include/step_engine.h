@@ -0,0 +1,84 @@
+#ifndef STEP_ENGINE_H
+#define STEP_ENGINE_H
+
+#include <vector>
+#include "boundary.h"
+#include "ensemble.h"
+#include "moments.h"
+#include "passage.h"
+#include "sampler.h"
+#include "worker_pool.h"
+
+// Сколько частиц обрабатывается за один вызов пакетного генератора
+const int STEP_BLOCK = 1024;
+
+// === Независимый поток случайных чисел одного рабочего потока ===
+struct StepStream {
+    BatchSampler sampler;
+    AlignedVector<float> step;
+    AlignedVector<float> gauss_x;
+    AlignedVector<float> gauss_y;
+    AlignedVector<float> gauss_z;
+    MomentSums sums;         // моменты куска после последнего шага
+    int kept = 0;            // сколько частиц куска осталось после поглощения
+};
+
+// === Параллельный шаг случайного блуждания ===
+// Ансамбль делится на thread_count непрерывных кусков, у каждого куска свой
+// пакетный генератор, засеянный парой (seed, номер куска). Поэтому при
+// одинаковых seed и thread_count результат не зависит от планировщика ОС.
+// Ядро шага — шаблон по числу измерений и политике границы (boundary.h):
+// step() выбирает вариант один раз за шаг, внутри блока ветвлений нет.
+// Поглощённые частицы выбрасываются из массивов: каждый кусок уплотняется
+// на месте в ядре, затем куски сдвигаются друг к другу, и particles.count
+// уменьшается. Порядок выживших сохраняется.
+// Монитор первого достижения, если подключён, смотрит каждый блок сразу
+// после сдвига; его маска уплотняется вместе с координатами.
+class StepEngine {
+public:
+    StepEngine(int thread_count, unsigned seed, float mean_free_path,
+               Domain domain = Domain{BOUNDARY_NONE, 0.0f});
+
+    // Один шаг всех частиц; возвращает управление, когда все куски готовы
+    void step(ParticleEnsemble& particles);
+
+    // Перезасевает генераторы тем же seed (для повторного прогона после R)
+    void reset();
+
+    int thread_count() const { return static_cast<int>(streams.size()); }
+    // Пул кусков шага; его же берёт окно для карты плотности, см. WorkerPool
+    WorkerPool& worker_pool() { return pool; }
+    const Domain& domain() const { return domain_; }
+
+    // nullptr отключает монитор; он должен быть настроен на thread_count() кусков
+    void attach_passage(PassageMonitor* monitor) { passage = monitor; }
+
+    // Моменты ансамбля после последнего step(): копятся прямо в ядре шага,
+    // отдельного прохода по координатам нет
+    EnsembleMoments moments(int step) const { return moments_from_sums(total, count, dimension, step); }
+
+    // Состояния генераторов всех кусков — для контрольных точек.
+    // restore_streams() возвращает false, если число кусков не совпадает.
+    void save_streams(std::vector<SamplerState>& states) const;
+    bool restore_streams(const std::vector<SamplerState>& states);
+
+private:
+    void seed_streams();
+    template <int D>
+    void step_dimension(ParticleEnsemble& particles);
+    template <int D, typename Boundary>
+    void step_range(int index, ParticleEnsemble& particles, const Boundary& boundary);
+    void compact_chunks(ParticleEnsemble& particles);
+
+    unsigned seed;
+    float mean_free_path;
+    Domain domain_;
+    PassageMonitor* passage = nullptr;
+    std::vector<StepStream> streams;
+    WorkerPool pool;
+    MomentSums total;
+    int count = 0;
+    int dimension = 2;
+};
+
+#endif // STEP_ENGINE_H
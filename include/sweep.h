@@ -0,0 +1,45 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <string>
+#include <vector>
+#include "types.h"
+
+// === Прогон серии независимых ансамблей по сетке параметров ===
+// Файл сетки — строки «ключ = значения через запятую», # — комментарий:
+//
+//     particles      = 10000, 100000
+//     mean_free_path = 1, 5, 10
+//     delay          = 1
+//     steps          = 1000, 10000
+//     dimension      = 2, 3
+//     repeats        = 4
+//
+// Прогоны — все сочетания значений, каждое повторено repeats раз. Пропущенный
+// ключ берёт одно значение по умолчанию. Seed прогона выводится из базового
+// seed и номера прогона, а каждый ансамбль считается в одном потоке, поэтому
+// строка сводки не зависит от -j и порядка, в котором прогоны закончились.
+typedef struct SweepOptions {
+    std::string grid_path;
+    std::string output_path; // пусто — сводка в stdout
+    int         thread_count;
+    unsigned    seed;        // базовый seed серии
+} SweepOptions;
+
+typedef struct SweepRun {
+    int      index;
+    int      repeat;
+    int      steps;
+    Settings settings;
+} SweepRun;
+
+// Разбирает аргументы вида --sweep GRID [-o FILE] [-j THREADS] [--seed S]
+bool parse_sweep_args(int argc, char** argv, SweepOptions& options);
+
+// Читает сетку и разворачивает её в список прогонов; false и сообщение в stderr при ошибке
+bool load_sweep_grid(const char* path, unsigned base_seed, std::vector<SweepRun>& runs);
+
+// Прогоны раздаются потокам по одному, крупные первыми; сводка — одна строка CSV на прогон
+int run_sweep(const SweepOptions& options);
+
+#endif // SWEEP_H
@@ -0,0 +1,105 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// === Как ограничивать историю траекторий ===
+typedef enum PathPolicy {
+    PATH_RING,     // последние K точек
+    PATH_STRIDE,   // каждая k-я точка; при переполнении k удваивается
+    PATH_ADAPTIVE  // прореживание в духе Дугласа–Пекера по каждой частице
+} PathPolicy;
+
+struct PathPoint {
+    float x;
+    float y;
+};
+
+// === Хранилище траекторий с фиксированным бюджетом памяти ===
+// Все точки лежат одной ареной [ячейка][частица]: ёмкость на частицу
+// считается из бюджета один раз, арена выделяется в configure() и живёт
+// до следующей смены размера. Запись шага — один непрерывный столбец,
+// поэтому страницы арены занимаются по мере записи, а не при старте.
+// Частицы пишутся синхронно, длина истории у всех одна, и clear() только
+// обнуляет счётчики — O(1) при любом N.
+// PATH_ADAPTIVE держит ещё запасную арену на половину ёмкости: прореживание
+// пишет туда, пока основную читают, и бюджет делится между ними.
+class TrajectoryStore {
+public:
+    TrajectoryStore() = default;
+
+    // max_points — верхняя граница точек на частицу (например, MAX_STEPS + 1)
+    void configure(int particle_count, PathPolicy policy, size_t budget_bytes, int max_points);
+
+    bool       enabled()  const { return capacity_ > 0; }
+    int        particles() const { return particle_count; }
+    PathPolicy policy()   const { return policy_; }
+    int        capacity() const { return capacity_; }
+    int        stride()   const { return stride_; }
+    size_t     memory_bytes() const { return (arena_points + staging_points) * sizeof(PathPoint); }
+
+    void clear();
+
+    // Записывает позиции всех частиц после шага step
+    void record(const float* x, const float* y, int step);
+
+    // Переполнение PATH_ADAPTIVE в два этапа. simplify_due() — следующий record()
+    // прорежет историю; prepare_simplify() прореживает все траектории в запасную
+    // арену, только читая основную, и его можно звать без блокировки читателей.
+    // record() тогда лишь копирует готовый результат, а без подготовки прореживает сам.
+    bool simplify_due() const { return policy_ == PATH_ADAPTIVE && enabled() && length_ == capacity_; }
+    void prepare_simplify();
+
+    int path_length() const { return length_; }
+
+    // Для инкрементальной отрисовки: сколько точек записано с последней очистки,
+    // номер «раскладки» (меняется при очистке и прореживании) и ячейка арены,
+    // в которую легла точка с данным номером
+    long long stored()   const { return stored_; }
+    unsigned  revision() const { return revision_; }
+    bool      wrapped()  const { return policy_ == PATH_RING && written > capacity_; }
+    int slot_of(long long index) const {
+        return policy_ == PATH_RING ? static_cast<int>(index % capacity_) : static_cast<int>(index - slot_base);
+    }
+    const PathPoint& at_slot(int particle, int slot) const {
+        return points[static_cast<size_t>(slot) * particle_count + particle];
+    }
+
+    // k-я по времени точка траектории частицы
+    const PathPoint& point(int particle, int k) const {
+        const int slot = wrapped() ? static_cast<int>((written + k) % capacity_) : k;
+        return at_slot(particle, slot);
+    }
+
+private:
+    void halve_stride();
+    void simplify(int particle, PathPoint* out);
+
+    int particle_count = 0;
+    int capacity_ = 0;
+    PathPolicy policy_ = PATH_STRIDE;
+    int stride_ = 1;
+    int length_ = 0;       // длина истории, общая для всех частиц
+    long long written = 0; // сколько точек записано в кольцо
+    long long stored_ = 0;
+    long long slot_base = 0;
+    unsigned revision_ = 0;
+    size_t arena_points = 0;
+    std::unique_ptr<PathPoint[]> points;
+    // Прореженная история [ячейка][частица], готовая к копированию в начало арены
+    size_t staging_points = 0;
+    std::unique_ptr<PathPoint[]> staging;
+    bool staged = false;
+
+    // Рабочие массивы прореживания, чтобы не выделять память на каждом переполнении;
+    // row — траектория одной частицы, собранная из столбцов арены подряд
+    std::vector<PathPoint> row;
+    std::vector<float> importance;
+    std::vector<int> order;
+    std::vector<std::pair<int, int>> segments;
+};
+
+#endif // TRAJECTORY_H
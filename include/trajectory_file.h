@@ -0,0 +1,52 @@
+#ifndef TRAJECTORY_FILE_H
+#define TRAJECTORY_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// === Формат файла траекторий ===
+// [заголовок 64 байта][кадр 0][кадр 1]...
+// Кадр: [шаг int32][резерв uint32][x float32 * N][y float32 * N], в 3D
+// ещё [z float32 * N]. В 1D y пишется нулевым, чтобы 1D и 2D читались одинаково.
+// Все кадры одного размера, поэтому кадр k лежит по смещению
+// header_bytes + k * frame_bytes(N). Числа пишутся в порядке байт машины
+// (на x86 и ARM — little-endian).
+const char     TRAJECTORY_MAGIC[8]      = {'B', 'M', 'T', 'R', 'A', 'J', '0', '1'};
+const uint32_t TRAJECTORY_VERSION       = 1;
+
+typedef struct TrajectoryFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    uint32_t particle_count;
+    uint32_t seed;
+    float    mean_free_path;
+    uint32_t stride;         // шагов между соседними кадрами
+    uint32_t delay;          // время шага, мкс
+    uint32_t dimension;      // 1, 2 или 3; 0 — файл до 3D, считается 2D
+    uint64_t frame_count;    // дописывается при закрытии; 0 — считать по размеру файла
+    uint8_t  padding[16];
+} TrajectoryFileHeader;
+
+static_assert(sizeof(TrajectoryFileHeader) == 64, "trajectory header must stay 64 bytes");
+
+typedef struct TrajectoryFrameHeader {
+    int32_t  step;
+    uint32_t reserved;
+} TrajectoryFrameHeader;
+
+inline int trajectory_dimension(const TrajectoryFileHeader& header) {
+    return header.dimension == 0 ? 2 : static_cast<int>(header.dimension);
+}
+
+// Сколько осей лежит в кадре: x и y всегда, z — только в 3D
+inline int trajectory_axes(int dimension) {
+    return dimension == 3 ? 3 : 2;
+}
+
+inline size_t trajectory_frame_bytes(uint32_t particle_count, int dimension) {
+    return sizeof(TrajectoryFrameHeader) +
+           trajectory_axes(dimension) * sizeof(float) * static_cast<size_t>(particle_count);
+}
+
+#endif // TRAJECTORY_FILE_H
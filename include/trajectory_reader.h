@@ -0,0 +1,49 @@
+#ifndef TRAJECTORY_READER_H
+#define TRAJECTORY_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "ensemble.h"
+#include "trajectory_file.h"
+
+// === Чтение файла траекторий через mmap ===
+// Файл отображается в память целиком, но читается только нужный кадр:
+// смещение кадра вычисляется по номеру, поэтому переход к любому шагу — O(1),
+// а в память попадают лишь страницы показанных кадров.
+class TrajectoryReader {
+public:
+    TrajectoryReader() = default;
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    bool open(const char* path);
+    void close();
+
+    const TrajectoryFileHeader& header() const { return header_; }
+    int       particle_count() const { return static_cast<int>(header_.particle_count); }
+    int       dimension() const { return trajectory_dimension(header_); }
+    long long frame_count() const { return frame_count_; }
+
+    int frame_step(long long frame) const;
+
+    // Копирует координаты кадра в ансамбль (размер и размерность ансамбля должны совпадать)
+    void read_frame(long long frame, ParticleEnsemble& particles) const;
+
+    // Подсказка ядру подгрузить кадр заранее (следующий по ходу воспроизведения)
+    void prefetch(long long frame) const;
+
+private:
+    const unsigned char* frame_data(long long frame) const {
+        return data + header_.header_bytes + static_cast<size_t>(frame) * frame_bytes;
+    }
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    size_t frame_bytes = 0;
+    long long frame_count_ = 0;
+    TrajectoryFileHeader header_{};
+};
+
+#endif // TRAJECTORY_READER_H
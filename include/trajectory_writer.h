@@ -0,0 +1,69 @@
+#ifndef TRAJECTORY_WRITER_H
+#define TRAJECTORY_WRITER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "types.h"
+#include "ensemble.h"
+#include "trajectory_file.h"
+
+// Размер одного буфера записи; кадр больше буфера получает буфер по своему размеру
+const size_t WRITER_BUFFER_BYTES = 16u << 20;
+// Сколько буферов в обороте: один заполняется, остальные ждут диска
+const int    WRITER_BUFFER_COUNT = 3;
+
+// === Потоковая запись кадров на диск ===
+// Поток симуляции только копирует координаты в текущий буфер. Полный буфер
+// уходит в очередь, которую разбирает отдельный поток записи. Если диск не
+// успевает и свободных буферов нет, submit() ждёт — кадры не теряются.
+class TrajectoryWriter {
+public:
+    TrajectoryWriter() = default;
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    // Создаёт файл (перезаписывая старый) и пишет заголовок
+    bool open(const char* path, const Settings& settings, int stride);
+    bool is_open() const { return file != nullptr; }
+    int  stride() const { return static_cast<int>(header.stride); }
+
+    // Пишет кадр, если step кратен stride (ансамбль — той размерности, с которой открыт файл)
+    void submit(int step, const ParticleEnsemble& particles);
+
+    // Дописывает всё отправленное и число кадров в заголовок
+    void close();
+
+    // Начинает тот же файл заново (после сброса симуляции)
+    bool restart();
+
+private:
+    void writer_loop();
+    void hand_off();
+
+    std::string path;
+    FILE* file = nullptr;
+    TrajectoryFileHeader header{};
+    size_t frame_bytes = 0;
+    size_t buffer_bytes = 0;
+    uint64_t frames_submitted = 0;
+
+    std::vector<char> current;
+    std::vector<std::vector<char>> free_buffers;
+    std::deque<std::vector<char>> pending;
+
+    std::mutex mutex;
+    std::condition_variable pending_cv;
+    std::condition_variable free_cv;
+    bool stopping = false;
+    bool failed = false;
+    std::thread worker;
+};
+
+#endif // TRAJECTORY_WRITER_H
@@ -3,21 +3,38 @@
 
 #include <SFML/Graphics.hpp>
 
+class ProfileDump;
+
 typedef struct Settings {
     int particle_count;
     int mean_free_path;
     int delay;
+    int dimension;       // 1, 2 или 3
+    int boundary;        // BoundaryKind: 0 — без границ
+    int domain_size;     // сторона ящика или радиус круга
+    int thread_count;
+    unsigned seed;
+    int steps_per_frame; // 0 — без ограничения
+    int path_policy;     // PathPolicy: 0 — кольцо, 1 — каждая k-я, 2 — адаптивно
+    int path_budget_mb;
 } Settings;
 
+// === Файлы, которые производит прогон ===
+typedef struct OutputOptions {
+    const char* profile_path;    // покадровые замеры окна (.csv или .json), nullptr — нет
+    ProfileDump* profile_dump;   // файл profile_path, открытый в main на все прогоны окна
+    const char* trajectory_path; // бинарная запись траекторий, nullptr — нет
+    int         trajectory_stride; // кадр пишется каждые столько шагов
+    const char* checkpoint_path;     // контрольные точки, nullptr — нет
+    int         checkpoint_interval; // точка сохраняется каждые столько шагов
+    const char* resume_path;         // продолжить с контрольной точки, nullptr — с нуля
+    const char* passage_radii;       // радиусы первого достижения через запятую, nullptr — без монитора
+    const char* passage_path;        // гистограммы времён первого достижения (CSV), nullptr — нет
+} OutputOptions;
+
 typedef enum AppState {
     MENU,
     SIMULATION
 } AppState;
 
-struct Particle {
-    sf::Vector2f position;
-    std::vector<sf::Vertex> path;
-    sf::Color color;
-};
-
 #endif // TYPES_H
@@ -0,0 +1,48 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// === Постоянный пул потоков для разбиения работы на куски ===
+// run() раздаёт куски 0..size()-1: нулевой считает вызывающий поток,
+// остальные — потоки пула. Разбиение фиксировано, поэтому результат
+// не зависит от того, в каком порядке потоки проснулись. Вызовы run() из
+// разных потоков выполняются по очереди: так один пул делят шаг симуляции
+// и карта плотности окна, и ядер не становится занято вдвое больше.
+class WorkerPool {
+public:
+    explicit WorkerPool(int thread_count);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Выполняет task(номер куска) для всех кусков и ждёт завершения
+    void run(const std::function<void(int)>& task);
+
+    // Начало куска index при делении count элементов на chunks частей
+    static int chunk_begin(int count, int index, int chunks) {
+        return static_cast<int>(static_cast<long long>(count) * index / chunks);
+    }
+
+private:
+    void worker_loop(int index);
+
+    std::vector<std::thread> workers;
+    std::mutex run_mutex; // один run() за раз
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    const std::function<void(int)>* current = nullptr;
+    unsigned generation = 0;
+    int pending = 0;
+    bool stopping = false;
+};
+
+#endif // WORKER_POOL_H
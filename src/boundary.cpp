@@ -0,0 +1,45 @@
+#include "boundary.h"
+#include <cstring>
+
+static const char* const BOUNDARY_NAMES[BOUNDARY_KIND_COUNT] = {
+    "none", "periodic", "reflecting", "absorbing", "circular"
+};
+
+Domain domain_from_settings(const Settings& settings) {
+    Domain domain;
+    domain.kind = settings.boundary >= 0 && settings.boundary < BOUNDARY_KIND_COUNT
+                      ? static_cast<BoundaryKind>(settings.boundary) : BOUNDARY_NONE;
+    domain.size = static_cast<float>(settings.domain_size);
+    if (domain.size <= 0.0f)
+        domain.kind = BOUNDARY_NONE;
+    return domain;
+}
+
+const char* boundary_name(BoundaryKind kind) {
+    return kind >= 0 && kind < BOUNDARY_KIND_COUNT ? BOUNDARY_NAMES[kind] : "unknown";
+}
+
+bool parse_boundary(const char* name, BoundaryKind& kind) {
+    for (int i = 0; i < BOUNDARY_KIND_COUNT; ++i) {
+        if (!strcmp(name, BOUNDARY_NAMES[i])) {
+            kind = static_cast<BoundaryKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+double equilibrium_r_squared(const Domain& domain, int dimension) {
+    const double size = domain.size;
+    switch (domain.kind) {
+        // Равномерно в [-L/2, L/2]: L² / 12 на ось
+        case BOUNDARY_PERIODIC:
+        case BOUNDARY_REFLECTING:
+            return dimension * size * size / 12.0;
+        // Равномерно в d-мерном шаре радиуса R: ⟨r²⟩ = d R² / (d + 2)
+        case BOUNDARY_CIRCULAR:
+            return dimension * size * size / (dimension + 2.0);
+        default:
+            return 0.0;
+    }
+}
@@ -0,0 +1,171 @@
+#include "chart.h"
+#include <algorithm>
+#include <cmath>
+
+// Длина стрелки на концах отрезка add_span, в пикселях
+static const float ARROW_LENGTH = 10.0f;
+
+Chart::Chart(const sf::Font& font, const sf::FloatRect& area, const std::string& title,
+             const std::string& x_label, const std::string& y_label, int curve_count)
+    : font(font),
+      area(area),
+      frame(sf::Lines, 4),
+      tick_marks(sf::Lines),
+      curves(curve_count, sf::VertexArray(sf::LineStrip)),
+      marks(sf::Lines) {
+    const float left   = area.left;
+    const float top    = area.top;
+    const float right  = area.left + area.width;
+    const float bottom = area.top + area.height;
+
+    // Оси
+    frame[0] = sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White);
+    frame[1] = sf::Vertex(sf::Vector2f(right, bottom), sf::Color::White);
+    frame[2] = sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White);
+    frame[3] = sf::Vertex(sf::Vector2f(left, top), sf::Color::White);
+
+    // Заголовок и подписи осей
+    sf::Text title_text(title, font, 20);
+    title_text.setFillColor(sf::Color(160, 120, 140));
+    title_text.setPosition(10, 10);
+    captions.push_back(title_text);
+
+    sf::Text label_x(x_label, font, 16);
+    label_x.setFillColor(sf::Color::White);
+    label_x.setPosition(left + area.width / 2 - 30, bottom + 40);
+    captions.push_back(label_x);
+
+    sf::Text label_y(y_label, font, 16);
+    label_y.setFillColor(sf::Color::White);
+    label_y.setRotation(-90);
+    label_y.setPosition(left - 50, top + area.height / 2 - 20);
+    captions.push_back(label_y);
+}
+
+float Chart::nice_ceiling(float value) {
+    if (!(value > 0.0f))
+        return 1.0f;
+    const float decade = std::pow(10.0f, std::floor(std::log10(value)));
+    for (float step : {1.0f, 2.0f, 5.0f}) {
+        if (value <= step * decade * 1.0001f)
+            return step * decade;
+    }
+    return 10.0f * decade;
+}
+
+sf::Vector2f Chart::to_pixels(float x, float y) const {
+    const float x_span = x_axis.max - x_axis.min;
+    const float y_span = y_axis.max - y_axis.min;
+    return sf::Vector2f(area.left + area.width * (x - x_axis.min) / x_span,
+                        area.top + area.height - area.height * (y - y_axis.min) / y_span);
+}
+
+void Chart::set_axes(const ChartAxis& x, const ChartAxis& y) {
+    const bool same = has_axes &&
+                      x.min == x_axis.min && x.max == x_axis.max && x.ticks == x_axis.ticks &&
+                      y.min == y_axis.min && y.max == y_axis.max && y.ticks == y_axis.ticks &&
+                      x.format == x_axis.format && y.format == y_axis.format;
+    x_axis = x;
+    y_axis = y;
+    has_axes = true;
+    if (!same)
+        rebuild_ticks();
+}
+
+void Chart::rebuild_ticks() {
+    const float left   = area.left;
+    const float bottom = area.top + area.height;
+
+    tick_marks.clear();
+    tick_labels.clear();
+
+    for (int i = 0; i <= x_axis.ticks; ++i) {
+        const float value = x_axis.min + (x_axis.max - x_axis.min) * i / x_axis.ticks;
+        const float x = left + area.width * i / x_axis.ticks;
+        tick_marks.append(sf::Vertex(sf::Vector2f(x, bottom), sf::Color::White));
+        tick_marks.append(sf::Vertex(sf::Vector2f(x, bottom + 5), sf::Color::White));
+
+        sf::Text label(x_axis.format(value), font, 14);
+        label.setFillColor(sf::Color::White);
+        label.setPosition(x - 10, bottom + 10);
+        tick_labels.push_back(label);
+    }
+
+    for (int i = 0; i <= y_axis.ticks; ++i) {
+        const float value = y_axis.min + (y_axis.max - y_axis.min) * i / y_axis.ticks;
+        const float y = bottom - area.height * i / y_axis.ticks;
+        tick_marks.append(sf::Vertex(sf::Vector2f(left, y), sf::Color::White));
+        tick_marks.append(sf::Vertex(sf::Vector2f(left - 5, y), sf::Color::White));
+
+        // Подписи по оси y прижаты вправо к засечкам
+        sf::Text label(y_axis.format(value), font, 14);
+        label.setFillColor(sf::Color::White);
+        label.setPosition(left - 10 - label.getLocalBounds().width, y - 10);
+        tick_labels.push_back(label);
+    }
+}
+
+void Chart::set_curve(int index, const float* xs, const float* ys, int count, sf::Color color) {
+    sf::VertexArray& curve = curves[index];
+    curve.resize(count);
+    for (int i = 0; i < count; ++i)
+        curve[i] = sf::Vertex(to_pixels(xs[i], ys[i]), color);
+}
+
+void Chart::clear_marks() {
+    marks.clear();
+}
+
+void Chart::add_line(sf::Vector2f from, sf::Vector2f to, sf::Color color) {
+    marks.append(sf::Vertex(to_pixels(from.x, from.y), color));
+    marks.append(sf::Vertex(to_pixels(to.x, to.y), color));
+}
+
+void Chart::add_span(float x_from, float x_to, float y, sf::Color color) {
+    const sf::Vector2f start = to_pixels(x_from, y);
+    const sf::Vector2f end   = to_pixels(x_to, y);
+
+    marks.append(sf::Vertex(start, color));
+    marks.append(sf::Vertex(end, color));
+    for (float dy : {-ARROW_LENGTH, ARROW_LENGTH}) {
+        marks.append(sf::Vertex(start, color));
+        marks.append(sf::Vertex(sf::Vector2f(start.x + ARROW_LENGTH, start.y + dy), color));
+        marks.append(sf::Vertex(end, color));
+        marks.append(sf::Vertex(sf::Vector2f(end.x - ARROW_LENGTH, end.y + dy), color));
+    }
+}
+
+void Chart::set_note(int index, const std::string& text, sf::Vector2f position, unsigned size, sf::Color color) {
+    if (index >= static_cast<int>(notes.size()))
+        notes.resize(index + 1, sf::Text("", font, size));
+
+    sf::Text& note = notes[index];
+    if (note.getString() != text)
+        note.setString(text);
+    note.setCharacterSize(size);
+    note.setFillColor(color);
+    note.setPosition(position);
+}
+
+void Chart::draw(sf::RenderTarget& target) const {
+    target.draw(frame);
+    for (const sf::Text& caption : captions)
+        target.draw(caption);
+
+    if (!has_axes)
+        return;
+
+    target.draw(tick_marks);
+    for (const sf::Text& label : tick_labels)
+        target.draw(label);
+    for (const sf::VertexArray& curve : curves) {
+        if (curve.getVertexCount() > 1)
+            target.draw(curve);
+    }
+    if (marks.getVertexCount() > 0)
+        target.draw(marks);
+    for (const sf::Text& note : notes) {
+        if (!note.getString().isEmpty())
+            target.draw(note);
+    }
+}
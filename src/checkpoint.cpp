@@ -0,0 +1,234 @@
+#include "checkpoint.h"
+#include "boundary.h"
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t payload_checksum(const Checkpoint& checkpoint) {
+    const size_t coordinates = sizeof(float) * checkpoint.particles.count;
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a(hash, checkpoint.streams.data(), sizeof(SamplerState) * checkpoint.streams.size());
+    hash = fnv1a(hash, checkpoint.particles.x.data(), coordinates);
+    hash = fnv1a(hash, checkpoint.particles.y.data(), coordinates);
+    if (checkpoint.particles.dimension == 3)
+        hash = fnv1a(hash, checkpoint.particles.z.data(), coordinates);
+    hash = fnv1a(hash, checkpoint.observables.data(), checkpoint.observables.size());
+    return hash;
+}
+
+bool save_checkpoint(const char* path, const Checkpoint& checkpoint) {
+    const Settings& settings = checkpoint.settings;
+
+    CheckpointHeader header{};
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version         = CHECKPOINT_VERSION;
+    header.header_bytes    = sizeof(CheckpointHeader);
+    header.particle_count  = static_cast<int32_t>(checkpoint.particles.x.size());
+    header.absorbed_count  = header.particle_count - checkpoint.particles.count;
+    header.mean_free_path  = settings.mean_free_path;
+    header.delay           = settings.delay;
+    header.dimension       = checkpoint.particles.dimension;
+    header.boundary        = settings.boundary;
+    header.domain_size     = settings.domain_size;
+    header.thread_count    = settings.thread_count;
+    header.seed            = settings.seed;
+    header.steps_per_frame = settings.steps_per_frame;
+    header.path_policy     = settings.path_policy;
+    header.path_budget_mb  = settings.path_budget_mb;
+    header.step            = checkpoint.step;
+    header.stream_count    = static_cast<uint32_t>(checkpoint.streams.size());
+    header.observables_bytes = static_cast<uint32_t>(checkpoint.observables.size());
+    header.checksum        = payload_checksum(checkpoint);
+
+    const std::string temporary = std::string(path) + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file) {
+        fprintf(stderr, "Error while opening %s\n", temporary.c_str());
+        return false;
+    }
+
+    const size_t coordinates = checkpoint.particles.count;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(checkpoint.streams.data(), sizeof(SamplerState), checkpoint.streams.size(), file)
+                  == checkpoint.streams.size() &&
+              fwrite(checkpoint.particles.x.data(), sizeof(float), coordinates, file) == coordinates &&
+              fwrite(checkpoint.particles.y.data(), sizeof(float), coordinates, file) == coordinates &&
+              (checkpoint.particles.dimension != 3 ||
+               fwrite(checkpoint.particles.z.data(), sizeof(float), coordinates, file) == coordinates) &&
+              fwrite(checkpoint.observables.data(), 1, checkpoint.observables.size(), file)
+                  == checkpoint.observables.size();
+    // Данные должны дойти до диска раньше, чем переименование сделает их видимыми
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(temporary.c_str(), path) != 0) {
+        fprintf(stderr, "Error while writing %s\n", path);
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Больше истории и кольца MSD(t) полного размера снимок быть не может
+static const size_t MAX_OBSERVABLES_BYTES = 2 * sizeof(int32_t) + MOMENT_HISTORY_CAPACITY * sizeof(EnsembleMoments) +
+                                            3 * sizeof(int32_t) + 4 * sizeof(double) +
+                                            MSD_RING_CAPACITY * sizeof(MsdPoint);
+
+static bool read_header(FILE* file, const char* path, CheckpointHeader& header) {
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_VERSION || header.header_bytes != sizeof(CheckpointHeader) ||
+        header.particle_count <= 0 || header.stream_count == 0 ||
+        header.absorbed_count < 0 || header.absorbed_count > header.particle_count ||
+        header.observables_bytes > MAX_OBSERVABLES_BYTES ||
+        header.dimension < 0 || header.dimension > 3 ||
+        header.boundary < 0 || header.boundary >= BOUNDARY_KIND_COUNT) {
+        fprintf(stderr, "%s is not a checkpoint file\n", path);
+        return false;
+    }
+    return true;
+}
+
+static void header_settings(const CheckpointHeader& header, Settings& settings) {
+    settings.particle_count  = header.particle_count;
+    settings.mean_free_path  = header.mean_free_path;
+    settings.delay           = header.delay;
+    settings.dimension       = header.dimension == 0 ? 2 : header.dimension;
+    settings.boundary        = header.boundary;
+    settings.domain_size     = header.domain_size;
+    settings.thread_count    = header.thread_count;
+    settings.seed            = header.seed;
+    settings.steps_per_frame = header.steps_per_frame;
+    settings.path_policy     = header.path_policy;
+    settings.path_budget_mb  = header.path_budget_mb;
+}
+
+bool load_checkpoint_settings(const char* path, Settings& settings) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Error while opening %s\n", path);
+        return false;
+    }
+
+    CheckpointHeader header;
+    const bool ok = read_header(file, path, header);
+    fclose(file);
+    if (ok)
+        header_settings(header, settings);
+    return ok;
+}
+
+bool load_checkpoint(const char* path, Checkpoint& checkpoint) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Error while opening %s\n", path);
+        return false;
+    }
+
+    CheckpointHeader header;
+    if (!read_header(file, path, header)) {
+        fclose(file);
+        return false;
+    }
+    header_settings(header, checkpoint.settings);
+    checkpoint.step = header.step;
+    checkpoint.streams.resize(header.stream_count);
+    // Ёмкость — все N частиц, чтобы сброс вернул и поглощённые; живы первые N - absorbed
+    checkpoint.particles = ParticleEnsemble(header.particle_count, checkpoint.settings.dimension);
+    checkpoint.particles.count = header.particle_count - header.absorbed_count;
+
+    const size_t coordinates = checkpoint.particles.count;
+    const bool ok = fread(checkpoint.streams.data(), sizeof(SamplerState), header.stream_count, file)
+                        == header.stream_count &&
+                    fread(checkpoint.particles.x.data(), sizeof(float), coordinates, file) == coordinates &&
+                    fread(checkpoint.particles.y.data(), sizeof(float), coordinates, file) == coordinates &&
+                    (checkpoint.particles.dimension != 3 ||
+                     fread(checkpoint.particles.z.data(), sizeof(float), coordinates, file) == coordinates);
+    checkpoint.observables.resize(header.observables_bytes);
+    const bool observables_ok = ok && fread(checkpoint.observables.data(), 1, checkpoint.observables.size(), file)
+                                          == checkpoint.observables.size();
+    fclose(file);
+
+    if (!observables_ok || payload_checksum(checkpoint) != header.checksum) {
+        fprintf(stderr, "%s is truncated or corrupted\n", path);
+        return false;
+    }
+    return true;
+}
+
+void pack_observables(const MomentHistory& history, const MsdSeries& msd, std::vector<uint8_t>& out) {
+    out.clear();
+    history.save(out);
+    msd.save(out);
+}
+
+bool unpack_observables(const std::vector<uint8_t>& data, MomentHistory& history, MsdSeries& msd) {
+    const uint8_t* p = data.data();
+    const uint8_t* end = p + data.size();
+    return !data.empty() && history.load(p, end) && msd.load(p, end) && p == end;
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    wait();
+}
+
+void CheckpointWriter::configure(const char* path, int interval) {
+    wait();
+    this->path = path ? path : "";
+    this->interval = interval;
+}
+
+void CheckpointWriter::wait() {
+    if (worker.joinable())
+        worker.join();
+}
+
+void CheckpointWriter::capture(const Settings& settings, int step, const StepEngine& engine,
+                               const ParticleEnsemble& particles, const MomentHistory& history, const MsdSeries& msd) {
+    pending.settings = settings;
+    pending.settings.thread_count = engine.thread_count();
+    pending.step = step;
+    engine.save_streams(pending.streams);
+    if (pending.particles.x.size() != particles.x.size() || pending.particles.dimension != particles.dimension)
+        pending.particles = ParticleEnsemble(static_cast<int>(particles.x.size()), particles.dimension);
+    pending.particles.count = particles.count;
+    pending.particles.x = particles.x;
+    pending.particles.y = particles.y;
+    pending.particles.z = particles.z;
+    pack_observables(history, msd, pending.observables);
+}
+
+void CheckpointWriter::save_async(const Settings& settings, int step, const StepEngine& engine,
+                                  const ParticleEnsemble& particles, const MomentHistory& history,
+                                  const MsdSeries& msd) {
+    if (!enabled() || busy.load())
+        return;
+
+    wait();
+    capture(settings, step, engine, particles, history, msd);
+    busy = true;
+    worker = std::thread([this] {
+        save_checkpoint(path.c_str(), pending);
+        busy = false;
+    });
+}
+
+void CheckpointWriter::save_now(const Settings& settings, int step, const StepEngine& engine,
+                                const ParticleEnsemble& particles, const MomentHistory& history,
+                                const MsdSeries& msd) {
+    if (!enabled())
+        return;
+
+    wait();
+    capture(settings, step, engine, particles, history, msd);
+    save_checkpoint(path.c_str(), pending);
+}
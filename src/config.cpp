@@ -1,11 +1,22 @@
 #include "config.h"
 
-const int   WINDOW_WIDTH           = 1200;
-const int   WINDOW_HEIGHT          = 900;
-const int   MAX_STEPS              = 10000;
-const int   DEFAULT_PARTICLE_COUNT = 1000;
-const int   DEFAULT_STEP_SIZE      = 5;
-const int   DEFAULT_DELAY          = 1;
-const float MOVE_CAMERA_FACTOR     = 5.0f;
-const float ZOOM_IN_CAMERA_FACTOR  = 1.2f;
-const float ZOOM_OUT_CAMERA_FACTOR = 1.0f / ZOOM_IN_CAMERA_FACTOR;
+const int   WINDOW_WIDTH                = 1200;
+const int   WINDOW_HEIGHT               = 900;
+const int   MAX_STEPS                   = 10000;
+const int   DEFAULT_PARTICLE_COUNT      = 1000;
+const int   DEFAULT_STEP_SIZE           = 5;
+const int   DEFAULT_DELAY               = 1;
+const int   DEFAULT_DIMENSION           = 2;
+const int   MAX_DIMENSION               = 3;
+const int   DEFAULT_BOUNDARY            = 0; // BOUNDARY_NONE
+const int   DEFAULT_DOMAIN_SIZE         = 400;
+const int   MAX_THREAD_COUNT            = 64;
+const int   DEFAULT_STEPS_PER_FRAME     = 1;
+const int   DEFAULT_PATH_POLICY         = 1; // PATH_STRIDE
+const int   DEFAULT_PATH_BUDGET_MB      = 64;
+const int   DEFAULT_RECORD_STRIDE       = 1;
+const int   DEFAULT_CHECKPOINT_INTERVAL = 1000;
+const int   DEFAULT_FIT_INTERVAL        = 100;
+const float MOVE_CAMERA_FACTOR          = 5.0f;
+const float ZOOM_IN_CAMERA_FACTOR       = 1.2f;
+const float ZOOM_OUT_CAMERA_FACTOR      = 1.0f / ZOOM_IN_CAMERA_FACTOR;
@@ -0,0 +1,30 @@
+#include "ensemble.h"
+#include <algorithm>
+
+static const sf::Color PARTICLE_COLORS[] = {
+    sf::Color(255, 100, 100),
+    sf::Color(100, 255, 100),
+    sf::Color(100, 100, 255),
+    sf::Color(255, 100, 255),
+    sf::Color(100, 255, 255),
+    sf::Color(255, 255, 100)
+};
+
+sf::Color particle_color(int index) {
+    return PARTICLE_COLORS[index % 6];
+}
+
+ParticleEnsemble::ParticleEnsemble(int particle_count, int dimension)
+    : count(particle_count),
+      dimension(dimension),
+      x(particle_count, 0.0f),
+      y(particle_count, 0.0f),
+      z(dimension == 3 ? particle_count : 0, 0.0f) {
+}
+
+void ParticleEnsemble::reset() {
+    count = static_cast<int>(x.size());
+    std::fill(x.begin(), x.end(), 0.0f);
+    std::fill(y.begin(), y.end(), 0.0f);
+    std::fill(z.begin(), z.end(), 0.0f);
+}
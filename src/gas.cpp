@@ -0,0 +1,191 @@
+#include "gas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+static const double PI = 3.14159265358979323846;
+
+// Соседние ячейки, которые проверяет ячейка: сама, справа и три сверху.
+// Каждая пара соседних ячеек попадает в обход ровно один раз.
+static const int HALF_STENCIL[][2] = {{0, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+bool HardDiskGas::configure(ParticleEnsemble& particles, float diameter, float mean_free_path, unsigned seed) {
+    count = particles.count;
+    diameter_ = diameter;
+    if (particles.dimension != 2 || count <= 0 || diameter <= 0.0f) {
+        fprintf(stderr, "Hard-disk gas needs a 2D ensemble and a positive diameter\n");
+        return false;
+    }
+
+    // Диск заметает полосу шириной 2d, относительная скорость в √2 раз больше средней:
+    // λ = 1 / (2√2 n d), n = N / L²  =>  L² = 2√2 N d λ
+    box = static_cast<float>(std::sqrt(2.0 * std::sqrt(2.0) * count * diameter * mean_free_path));
+    // Ячейка не меньше диаметра, а ячеек не больше, чем частиц: обход сетки остаётся O(N)
+    cells_per_side = std::min(static_cast<int>(box / diameter),
+                              static_cast<int>(std::sqrt(static_cast<double>(count))));
+    const int sites_per_side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+    const float spacing = box / sites_per_side;
+    if (cells_per_side < 3 || spacing <= diameter) {
+        fprintf(stderr, "Gas too dense: %d disks of diameter %.3g do not fit a box of %.3g for mean free path %.3g\n",
+                count, diameter, box, mean_free_path);
+        return false;
+    }
+    cell_size = box / cells_per_side;
+
+    box_x.resize(count);
+    box_y.resize(count);
+    vx.resize(count);
+    vy.resize(count);
+    cell_of.resize(count);
+    order.resize(count);
+    cell_start.assign(static_cast<size_t>(cells_per_side) * cells_per_side + 1, 0);
+    last_collision.assign(count, -1);
+    speed.resize(count);
+
+    // Узлы квадратной решётки со сдвигом внутри узла: зазор между соседями не меньше нуля
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> jitter(0.0f, spacing - diameter);
+    for (int i = 0; i < count; ++i) {
+        box_x[i] = (i % sites_per_side) * spacing + jitter(gen);
+        box_y[i] = (i / sites_per_side) * spacing + jitter(gen);
+    }
+
+    // Компоненты скорости ~ N(0, σ_v²), средний пробег за шаг — GAS_STEP_FRACTION диаметра
+    BatchSampler sampler;
+    sampler.seed(seed, 0);
+    sampler.fill_gaussian(vx.data(), vy.data(), count);
+    const double sigma_v = GAS_STEP_FRACTION * diameter / std::sqrt(PI / 2.0);
+    double mean_vx = 0.0, mean_vy = 0.0;
+    for (int i = 0; i < count; ++i) {
+        mean_vx += vx[i];
+        mean_vy += vy[i];
+    }
+    mean_vx /= count;
+    mean_vy /= count;
+
+    // Без общего импульса облако не дрейфует и MSD — чистая самодиффузия
+    double speed_sum = 0.0;
+    for (int i = 0; i < count; ++i) {
+        vx[i] = static_cast<float>((vx[i] - mean_vx) * sigma_v);
+        vy[i] = static_cast<float>((vy[i] - mean_vy) * sigma_v);
+        speed[i] = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i]);
+        speed_sum += speed[i];
+    }
+    mean_speed_ = speed_sum / count;
+    packing_fraction_ = count * PI * diameter * diameter / 4.0 / (static_cast<double>(box) * box);
+
+    particles.reset();
+    steps = 0;
+    collisions_ = 0;
+    flights = 0;
+    flight_sum = 0.0;
+    sums = MomentSums{};
+    return true;
+}
+
+// Полёт по прямой: смещение ансамбля без свёртки, координата в ящике — со свёрткой
+void HardDiskGas::move(ParticleEnsemble& particles) {
+    float* x = particles.x.data();
+    float* y = particles.y.data();
+
+    sums = MomentSums{};
+    for (int i = 0; i < count; i += MOMENT_BLOCK) {
+        const int n = std::min(MOMENT_BLOCK, count - i);
+        for (int j = i; j < i + n; ++j) {
+            x[j] += vx[j];
+            y[j] += vy[j];
+            box_x[j] += vx[j];
+            box_y[j] += vy[j];
+            box_x[j] -= box * std::floor(box_x[j] / box);
+            box_y[j] -= box * std::floor(box_y[j] / box);
+        }
+        accumulate_block<2>(x + i, y + i, nullptr, n, sums);
+    }
+}
+
+// Сортировка подсчётом по ячейкам: счётчики, префиксные суммы, раскладка
+void HardDiskGas::build_cells() {
+    const int cells = cells_per_side * cells_per_side;
+    std::fill(cell_start.begin(), cell_start.end(), 0);
+
+    const float inv_cell = 1.0f / cell_size;
+    for (int i = 0; i < count; ++i) {
+        const int cx = std::min(static_cast<int>(box_x[i] * inv_cell), cells_per_side - 1);
+        const int cy = std::min(static_cast<int>(box_y[i] * inv_cell), cells_per_side - 1);
+        cell_of[i] = cy * cells_per_side + cx;
+        ++cell_start[cell_of[i] + 1];
+    }
+    for (int c = 0; c < cells; ++c)
+        cell_start[c + 1] += cell_start[c];
+
+    // cell_start служит курсором записи и после раскладки сдвинут на ячейку — возвращаем
+    for (int i = 0; i < count; ++i)
+        order[cell_start[cell_of[i]]++] = i;
+    for (int c = cells; c > 0; --c)
+        cell_start[c] = cell_start[c - 1];
+    cell_start[0] = 0;
+}
+
+void HardDiskGas::end_flight(int index) {
+    if (last_collision[index] >= 0) {
+        flight_sum += static_cast<double>(speed[index]) * (steps - last_collision[index]);
+        ++flights;
+    }
+    last_collision[index] = steps;
+    speed[index] = std::sqrt(vx[index] * vx[index] + vy[index] * vy[index]);
+}
+
+// Пары из ячеек a и b; при a == b каждая пара берётся один раз
+void HardDiskGas::collide_cells(int a, int b) {
+    const float half = 0.5f * box;
+    const float contact_sq = diameter_ * diameter_;
+
+    for (int p = cell_start[a]; p < cell_start[a + 1]; ++p) {
+        const int i = order[p];
+        for (int q = a == b ? p + 1 : cell_start[b]; q < cell_start[b + 1]; ++q) {
+            const int j = order[q];
+
+            // Ближайший образ соседа в периодическом ящике
+            float dx = box_x[j] - box_x[i];
+            float dy = box_y[j] - box_y[i];
+            dx -= dx > half ? box : dx < -half ? -box : 0.0f;
+            dy -= dy > half ? box : dy < -half ? -box : 0.0f;
+            const float dist_sq = dx * dx + dy * dy;
+            if (dist_sq >= contact_sq || dist_sq == 0.0f)
+                continue;
+
+            // Удар только у сближающейся пары: иначе она уже разлетается после прошлого шага
+            const float approach = (vx[j] - vx[i]) * dx + (vy[j] - vy[i]) * dy;
+            if (approach >= 0.0f)
+                continue;
+
+            // Равные массы: пара обменивается нормальными составляющими скоростей
+            const float impulse = approach / dist_sq;
+            vx[i] += impulse * dx;
+            vy[i] += impulse * dy;
+            vx[j] -= impulse * dx;
+            vy[j] -= impulse * dy;
+            ++collisions_;
+            end_flight(i);
+            end_flight(j);
+        }
+    }
+}
+
+void HardDiskGas::step(ParticleEnsemble& particles) {
+    ++steps;
+    move(particles);
+    build_cells();
+
+    const int m = cells_per_side;
+    for (int cy = 0; cy < m; ++cy) {
+        for (int cx = 0; cx < m; ++cx) {
+            for (const auto& offset : HALF_STENCIL) {
+                const int nx = (cx + offset[0] + m) % m;
+                const int ny = (cy + offset[1]) % m;
+                collide_cells(cy * m + cx, ny * m + nx);
+            }
+        }
+    }
+}
@@ -0,0 +1,463 @@
+#include "headless.h"
+#include "config.h"
+#include "boundary.h"
+#include "ensemble.h"
+#include "step_engine.h"
+#include "gas.h"
+#include "radial_stats.h"
+#include "moments.h"
+#include "passage.h"
+#include "trajectory_writer.h"
+#include "checkpoint.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+void print_headless_usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s --headless -n N -l L -s STEPS [-d DIM] [--seed S] [-j THREADS] [-t DELAY] [-o FILE]\n"
+            "                     [--record FILE] [--record-every K]\n"
+            "  -n N         particle count\n"
+            "  -l L         mean free path (nm)\n"
+            "  -d DIM       number of dimensions: 1, 2 or 3 (default 2)\n"
+            "  -s STEPS     number of steps\n"
+            "  --seed S     RNG seed\n"
+            "  -j THREADS   worker threads\n"
+            "  -t DELAY     time per step (mcs), only used for D\n"
+            "  -o FILE      write statistics to FILE instead of stdout\n"
+            "  --record FILE    stream positions to a binary trajectory file\n"
+            "  --record-every K write every K-th step (default 1)\n"
+            "  --checkpoint FILE      save the full state to FILE periodically and at the end\n"
+            "  --checkpoint-every K   checkpoint interval in steps (default 1000)\n"
+            "  --resume FILE          continue from a checkpoint up to STEPS in total\n"
+            "  --moments FILE         write <r^2>, <r^4>, alpha2 and axis variances per step as CSV\n"
+            "  --fit-log FILE         write KS and chi2 against the chi distribution every --fit-every steps as CSV\n"
+            "  --fit-every K          goodness-of-fit interval in steps (default 100)\n"
+            "  --stop-ks D            stop early once the KS distance drops to D or below\n"
+            "  --gas DIAMETER         2D hard-disk gas instead of independent walkers: disks of this\n"
+            "                         diameter collide in a periodic box sized so that the dilute-gas\n"
+            "                         mean free path equals -l; reports the measured free path\n"
+            "  --boundary KIND        none, periodic, reflecting or absorbing box of side --domain,\n"
+            "                         or circular: reflecting circle (sphere) of radius --domain\n"
+            "  --domain SIZE          box side or circle radius (default 400)\n"
+            "  --passage R[,R...]     record first-passage times to up to 8 radii (and to absorbing\n"
+            "                         walls) and compare them with diffusion theory\n"
+            "  --passage-log FILE     write first-passage histograms with theory CDFs as CSV\n"
+            "\n"
+            "Usage: %s --sweep GRID [-o FILE] [-j THREADS] [--seed S]\n"
+            "  --sweep GRID  run every combination of 'particles', 'mean_free_path', 'delay',\n"
+            "                'steps', 'dimension' (and 'repeats') listed in GRID, one ensemble per thread;\n"
+            "                writes one CSV row per run (default seed 0)\n"
+            "\n"
+            "Usage: %s [--dim DIM] [--profile FILE] [--record FILE] [--record-every K] [--replay FILE]\n"
+            "          [--checkpoint FILE] [--checkpoint-every K] [--resume FILE] [--boundary KIND] [--domain SIZE]\n"
+            "          [--passage R[,R...]]\n"
+            "  --dim DIM       window mode in 1, 2 or 3 dimensions (also set in the menu)\n"
+            "  --profile FILE  window mode; dump per-frame timings to FILE\n"
+            "                  (.json for Chrome trace, CSV otherwise)\n"
+            "  --replay FILE   play back a recorded trajectory file\n",
+            program, program, program);
+}
+
+bool parse_headless_args(int argc, char** argv, HeadlessOptions& options) {
+    static const char* const VALUE_FLAGS[] = {"-n", "-l", "-s", "-d", "--seed", "-j", "-t", "-o",
+                                               "--record", "--record-every",
+                                               "--checkpoint", "--checkpoint-every", "--resume",
+                                               "--moments", "--fit-log", "--fit-every", "--stop-ks", "--gas",
+                                               "--boundary", "--domain", "--passage", "--passage-log"};
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "--headless"))
+            continue;
+
+        bool known = false;
+        for (const char* flag : VALUE_FLAGS)
+            known = known || !strcmp(arg, flag);
+        if (!known) {
+            fprintf(stderr, "Unknown argument %s\n", arg);
+            return false;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (!strcmp(arg, "-n"))
+            options.settings.particle_count = std::max(1, atoi(value));
+        else if (!strcmp(arg, "-l"))
+            options.settings.mean_free_path = std::max(1, atoi(value));
+        else if (!strcmp(arg, "-s"))
+            options.steps = std::max(0, atoi(value));
+        else if (!strcmp(arg, "-d"))
+            options.settings.dimension = std::clamp(atoi(value), 1, MAX_DIMENSION);
+        else if (!strcmp(arg, "--seed"))
+            options.settings.seed = strtoul(value, nullptr, 10);
+        else if (!strcmp(arg, "-j"))
+            options.settings.thread_count = std::clamp(atoi(value), 1, MAX_THREAD_COUNT);
+        else if (!strcmp(arg, "-t"))
+            options.settings.delay = std::max(1, atoi(value));
+        else if (!strcmp(arg, "--record"))
+            options.output.trajectory_path = value;
+        else if (!strcmp(arg, "--record-every"))
+            options.output.trajectory_stride = std::max(1, atoi(value));
+        else if (!strcmp(arg, "--checkpoint"))
+            options.output.checkpoint_path = value;
+        else if (!strcmp(arg, "--checkpoint-every"))
+            options.output.checkpoint_interval = std::max(1, atoi(value));
+        else if (!strcmp(arg, "--resume"))
+            options.output.resume_path = value;
+        else if (!strcmp(arg, "--moments"))
+            options.moments_path = value;
+        else if (!strcmp(arg, "--fit-log"))
+            options.fit_path = value;
+        else if (!strcmp(arg, "--fit-every"))
+            options.fit_interval = std::max(1, atoi(value));
+        else if (!strcmp(arg, "--stop-ks"))
+            options.stop_ks = std::max(0.0, atof(value));
+        else if (!strcmp(arg, "--gas"))
+            options.gas_diameter = std::max(0.0, atof(value));
+        else if (!strcmp(arg, "--boundary")) {
+            BoundaryKind kind;
+            if (!parse_boundary(value, kind)) {
+                fprintf(stderr, "Unknown boundary %s\n", value);
+                return false;
+            }
+            options.settings.boundary = kind;
+        } else if (!strcmp(arg, "--domain"))
+            options.settings.domain_size = std::max(1, atoi(value));
+        else if (!strcmp(arg, "--passage"))
+            options.output.passage_radii = value;
+        else if (!strcmp(arg, "--passage-log"))
+            options.output.passage_path = value;
+        else
+            options.output_path = value;
+    }
+    return true;
+}
+
+// Ряд моментов: одна строка на записанный шаг (при длинном прогоне — с прореживанием)
+static bool write_moment_history(const char* path, const MomentHistory& history) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Error while opening %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "step,mean_r_squared,mean_r_fourth,non_gaussian,mean_x,mean_y,mean_z,var_x,var_y,var_z\n");
+    for (int i = 0; i < history.size(); ++i) {
+        const EnsembleMoments& m = history.at(i);
+        fprintf(file, "%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", m.step, m.mean_r_squared,
+                m.mean_r_fourth, m.non_gaussian(), m.mean_x, m.mean_y, m.mean_z, m.var_x, m.var_y, m.var_z);
+    }
+    fclose(file);
+    return true;
+}
+
+// Гистограммы первого достижения: строка на столбец, по три колонки на ряд
+static bool write_passage_log(const char* path, const PassageMonitor& passage) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Error while opening %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "step_end");
+    for (int k = 0; k < passage.target_count(); ++k) {
+        const std::string name = passage.target_name(k);
+        fprintf(file, ",%s_count,%s_cdf,%s_theory_cdf", name.c_str(), name.c_str(), name.c_str());
+    }
+    fprintf(file, "\n");
+
+    for (int bin = 0; bin < passage.bins_used(); ++bin) {
+        const int end_step = (bin + 1) * passage.bin_steps();
+        fprintf(file, "%d", end_step);
+        for (int k = 0; k < passage.target_count(); ++k)
+            fprintf(file, ",%lld,%.6f,%.6f", passage.bin_count(k, bin), passage.empirical_cdf(k, bin),
+                    passage.theory_cdf(k, end_step));
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    return true;
+}
+
+int run_headless(const HeadlessOptions& options) {
+    // При продолжении ансамбль, seed и число потоков берутся из контрольной точки
+    Checkpoint resume;
+    if (options.output.resume_path && !load_checkpoint(options.output.resume_path, resume))
+        return -1;
+    const Settings settings = options.output.resume_path ? resume.settings : options.settings;
+    const int first_step = options.output.resume_path ? resume.step : 0;
+
+    // Состояние газа (скорости, ящик) в контрольную точку не входит
+    const bool gas_mode = options.gas_diameter > 0.0;
+    if (gas_mode && (options.output.resume_path || options.output.checkpoint_path)) {
+        fprintf(stderr, "--gas cannot be combined with --checkpoint or --resume\n");
+        return -1;
+    }
+    // У газа свой периодический ящик; кадр файла траекторий — все N частиц, а поглощение их выбрасывает
+    const Domain domain = domain_from_settings(settings);
+    if (gas_mode && domain.kind != BOUNDARY_NONE) {
+        fprintf(stderr, "--gas cannot be combined with --boundary\n");
+        return -1;
+    }
+    if (domain.kind == BOUNDARY_ABSORBING && options.output.trajectory_path) {
+        fprintf(stderr, "--record cannot be combined with --boundary absorbing\n");
+        return -1;
+    }
+    // Маска «уже дошла» в контрольную точку не входит, а газ шагает без ядра StepEngine
+    std::vector<float> passage_radii;
+    if (options.output.passage_radii) {
+        if (!parse_passage_radii(options.output.passage_radii, passage_radii)) {
+            fprintf(stderr, "--passage expects 1 to %d positive radii separated by commas\n", MAX_PASSAGE_RADII);
+            return -1;
+        }
+        if (gas_mode || options.output.resume_path) {
+            fprintf(stderr, "--passage cannot be combined with --gas or --resume\n");
+            return -1;
+        }
+    }
+
+    FILE* out = stdout;
+    if (!options.output_path.empty()) {
+        out = fopen(options.output_path.c_str(), "w");
+        if (!out) {
+            fprintf(stderr, "Error while opening %s\n", options.output_path.c_str());
+            return -1;
+        }
+    }
+
+    ParticleEnsemble particles(settings.particle_count, settings.dimension);
+    StepEngine engine(settings.thread_count, settings.seed, settings.mean_free_path, domain);
+    if (options.output.resume_path) {
+        particles = std::move(resume.particles);
+        // Другое число генераторов дало бы другой поток случайных чисел, а не продолжение
+        if (!engine.restore_streams(resume.streams)) {
+            fprintf(stderr, "Checkpoint %s has %zu random streams, the engine expects %d\n",
+                    options.output.resume_path, resume.streams.size(), engine.thread_count());
+            if (out != stdout)
+                fclose(out);
+            return -1;
+        }
+    }
+    HardDiskGas gas;
+    if (gas_mode && !gas.configure(particles, static_cast<float>(options.gas_diameter),
+                                   static_cast<float>(settings.mean_free_path), settings.seed)) {
+        if (out != stdout)
+            fclose(out);
+        return -1;
+    }
+
+    PassageMonitor passage;
+    if (!passage_radii.empty()) {
+        passage.configure(passage_radii, domain, settings.dimension, static_cast<float>(settings.mean_free_path),
+                          particles.count, engine.thread_count(), options.steps);
+        engine.attach_passage(&passage);
+    }
+
+    CheckpointWriter checkpoints;
+    checkpoints.configure(options.output.checkpoint_path, options.output.checkpoint_interval);
+
+    TrajectoryWriter writer;
+    if (options.output.trajectory_path) {
+        if (!writer.open(options.output.trajectory_path, settings, options.output.trajectory_stride)) {
+            if (out != stdout)
+                fclose(out);
+            return -1;
+        }
+        writer.submit(first_step, particles);
+    }
+
+    // Моменты приходят из ядра шага; отдельный проход нужен только для начального состояния.
+    // При продолжении история и MSD(t) берутся из точки, и начальный шаг в них уже есть.
+    MomentHistory history;
+    MsdSeries msd;
+    EnsembleMoments moments = measure_moments(particles, first_step);
+    const bool observables_resumed = options.output.resume_path && unpack_observables(resume.observables, history, msd);
+    if (!observables_resumed) {
+        history.clear();
+        msd.clear();
+        history.record(moments);
+        msd.record(first_step, moments.mean_r_squared);
+    }
+    // В точке без истории подгонка видела бы только шаги после продолжения
+    const bool fit_valid = !options.output.resume_path || observables_resumed;
+
+    // Согласие с χ-распределением раз в fit_interval шагов: в журнал и как критерий ранней остановки
+    FILE* fit_log = nullptr;
+    if (!options.fit_path.empty()) {
+        fit_log = fopen(options.fit_path.c_str(), "w");
+        if (!fit_log) {
+            fprintf(stderr, "Error while opening %s\n", options.fit_path.c_str());
+            if (out != stdout)
+                fclose(out);
+            return -1;
+        }
+        fprintf(fit_log, "step,ks,ks_p,chi2,dof\n");
+    }
+    const bool check_fit = fit_log || options.stop_ks > 0.0;
+    const double lambda_sq = static_cast<double>(settings.mean_free_path) * settings.mean_free_path;
+    // Дисперсия по одной оси за шаг: ⟨Δr²⟩ = 2λ² делится поровну между d осями
+    const double axis_variance = 2.0 * lambda_sq / settings.dimension;
+    RadialHistogram fit_histogram;
+    int converged_step = -1;
+
+    auto start = std::chrono::steady_clock::now();
+    int final_step = first_step;
+    for (int step = first_step + 1; step <= options.steps; ++step) {
+        if (gas_mode) {
+            gas.step(particles);
+            moments = gas.moments(step);
+        } else {
+            const int alive = particles.count;
+            engine.step(particles);
+            moments = engine.moments(step);
+            passage.record_step(step, alive - particles.count);
+        }
+        history.record(moments);
+        msd.record(step, moments.mean_r_squared);
+        writer.submit(step, particles);
+        if (checkpoints.due(step))
+            checkpoints.save_async(settings, step, engine, particles, history, msd);
+        final_step = step;
+
+        if (check_fit && step % options.fit_interval == 0) {
+            fit_histogram.build(particles.x.data(), particles.y.data(), particles.z_data(), particles.count);
+            const GoodnessOfFit fit = chi_goodness(fit_histogram, settings.dimension, axis_variance * step);
+            if (fit_log)
+                fprintf(fit_log, "%d,%.6f,%.6f,%.6f,%d\n", step, fit.ks, fit.ks_p, fit.chi2, fit.dof);
+            // Пустая гистограмма даёт ks = 0: поглощённый ансамбль — не сошедшийся
+            if (options.stop_ks > 0.0 && fit_histogram.total > 0 && fit.ks <= options.stop_ks) {
+                converged_step = step;
+                break;
+            }
+        }
+    }
+    // Время — только шаги: сброс файлов на диск в него не входит
+    auto finish = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(finish - start).count();
+    writer.close();
+    if (fit_log)
+        fclose(fit_log);
+    // Без единого шага точка совпала бы с исходной — и затёрла бы файл с прошлого прогона
+    if (final_step > first_step)
+        checkpoints.save_now(settings, final_step, engine, particles, history, msd);
+
+    // === Итоговая статистика ===
+    RadialHistogram histogram;
+    histogram.build(particles.x.data(), particles.y.data(), particles.z_data(), particles.count);
+
+    const double lambda = settings.mean_free_path;
+    const double avg_r_squared = moments.mean_r_squared;
+    const double R_prime = std::sqrt(avg_r_squared);
+    const double theoretical_R = lambda * std::sqrt(2.0 * final_step);
+    const double time = static_cast<double>(final_step) * settings.delay;
+    const double D_empirical = time > 0 ? avg_r_squared / (2.0 * settings.dimension * time) : 0.0;
+    const int steps_done = final_step - first_step;
+    const double particle_steps = static_cast<double>(particles.count) * steps_done;
+
+    fprintf(out, "particles        %d\n", particles.count);
+    fprintf(out, "mean_free_path   %d\n", settings.mean_free_path);
+    fprintf(out, "dimension        %d\n", settings.dimension);
+    fprintf(out, "boundary         %s\n", boundary_name(domain.kind));
+    fprintf(out, "steps            %d\n", final_step);
+    fprintf(out, "start_step       %d\n", first_step);
+    fprintf(out, "seed             %u\n", settings.seed);
+    fprintf(out, "threads          %d\n", engine.thread_count());
+    fprintf(out, "elapsed_sec      %.6f\n", elapsed);
+    fprintf(out, "steps_per_sec    %.3f\n", elapsed > 0 ? steps_done / elapsed : 0.0);
+    fprintf(out, "ns_per_particle_step %.3f\n", particle_steps > 0 ? elapsed * 1e9 / particle_steps : 0.0);
+    fprintf(out, "mean_r_squared   %.6f\n", avg_r_squared);
+    fprintf(out, "theory_r_squared %.6f\n", 2.0 * lambda * lambda * final_step);
+    fprintf(out, "rms_radius       %.6f\n", R_prime);
+    fprintf(out, "theory_radius    %.6f\n", theoretical_R);
+    fprintf(out, "D                %.6f\n", D_empirical);
+    fprintf(out, "mean_r_fourth    %.6f\n", moments.mean_r_fourth);
+    fprintf(out, "non_gaussian     %.6f\n", moments.non_gaussian());
+    fprintf(out, "var_x            %.6f\n", moments.var_x);
+    fprintf(out, "var_y            %.6f\n", moments.var_y);
+    if (settings.dimension == 3)
+        fprintf(out, "var_z            %.6f\n", moments.var_z);
+
+    // KS и χ² против χ-распределения по бинам итоговой гистограммы
+    const double sigma_sq = std::max(1e-5, axis_variance * final_step);
+    const GoodnessOfFit fit = chi_goodness(histogram, settings.dimension, sigma_sq);
+    fprintf(out, "ks               %.6f\n", fit.ks);
+    fprintf(out, "ks_p             %.6f\n", fit.ks_p);
+    fprintf(out, "chi2             %.6f\n", fit.chi2);
+    fprintf(out, "chi2_dof         %d\n", fit.dof);
+    if (converged_step >= 0)
+        fprintf(out, "converged_step   %d\n", converged_step);
+
+    // Ограниченная область: доля выживших или равновесный ⟨r²⟩ равномерного распределения
+    if (domain.kind != BOUNDARY_NONE) {
+        fprintf(out, "domain_size      %d\n", settings.domain_size);
+        if (domain.kind == BOUNDARY_ABSORBING) {
+            fprintf(out, "initial_particles %d\n", settings.particle_count);
+            fprintf(out, "survival_fraction %.6f\n", static_cast<double>(particles.count) / settings.particle_count);
+        } else {
+            fprintf(out, "equilibrium_r_squared %.6f\n", equilibrium_r_squared(domain, settings.dimension));
+        }
+    }
+
+    // Газ: длина пробега из столкновений против заданной -l (теория разреженного газа)
+    // и против неё же с поправкой Энскога на плотность
+    if (gas_mode) {
+        const double measured = gas.measured_free_path();
+        fprintf(out, "gas_diameter     %.6f\n", gas.diameter());
+        fprintf(out, "gas_box          %.6f\n", gas.box_size());
+        fprintf(out, "packing_fraction %.6f\n", gas.packing_fraction());
+        fprintf(out, "gas_mean_speed   %.6f\n", gas.mean_speed());
+        fprintf(out, "collisions       %lld\n", gas.collisions());
+        fprintf(out, "free_paths       %lld\n", gas.flight_count());
+        fprintf(out, "measured_free_path %.6f\n", measured);
+        fprintf(out, "input_free_path  %.6f\n", lambda);
+        fprintf(out, "enskog_free_path %.6f\n", lambda / gas.enskog_chi());
+        fprintf(out, "free_path_ratio  %.6f\n", measured / lambda);
+    }
+
+    // Первое достижение: доля дошедших к концу и среднее время против диффузии с D = λ²/d на шаг
+    for (int k = 0; k < passage.target_count(); ++k) {
+        const std::string name = "passage_" + passage.target_name(k);
+        fprintf(out, "%s_crossed %.6f\n", name.c_str(), static_cast<double>(passage.crossed(k)) / settings.particle_count);
+        fprintf(out, "%s_theory_crossed %.6f\n", name.c_str(), passage.theory_cdf(k, final_step));
+        fprintf(out, "%s_mean_steps %.6f\n", name.c_str(), passage.mean_time(k));
+        fprintf(out, "%s_theory_mean_steps %.6f\n", name.c_str(), passage.theory_mean(k));
+        fprintf(out, "%s_ks %.6f\n", name.c_str(), passage.ks_distance(k));
+    }
+
+    // Подгонка ⟨r²⟩ = 2d D t^α по логарифмической сетке шагов; при нормальной диффузии α = 1
+    double alpha = 0.0, D_fit = 0.0;
+    if (!fit_valid) {
+        fprintf(out, "msd_fit          unavailable: checkpoint has no MSD history\n");
+    } else if (msd.fit(settings.delay, settings.dimension, alpha, D_fit)) {
+        fprintf(out, "msd_alpha        %.6f\n", alpha);
+        fprintf(out, "msd_D_fit        %.6f\n", D_fit);
+    }
+
+    // Эмпирическая CDF радиуса против CDF χ-распределения с σ² = 2λ² * N / d
+    const int BIN_COUNT = 100;
+    const double max_radius = std::max(1e-5, static_cast<double>(histogram.max_radius()));
+
+    fprintf(out, "# r count cdf theory_cdf\n");
+    for (int i = 0; i < BIN_COUNT; ++i) {
+        double r = max_radius * i / (BIN_COUNT - 1);
+        double count = histogram.count_within(static_cast<float>(r));
+        fprintf(out, "%.6f %.0f %.6f %.6f\n", r, count,
+                static_cast<double>(count) / std::max(particles.count, 1),
+                chi_cdf(settings.dimension, r, sigma_sq));
+    }
+
+    if (out != stdout)
+        fclose(out);
+
+    if (!options.moments_path.empty() && !write_moment_history(options.moments_path.c_str(), history))
+        return -1;
+    if (options.output.passage_path && passage.enabled() && !write_passage_log(options.output.passage_path, passage))
+        return -1;
+    return 0;
+}
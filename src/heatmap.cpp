@@ -0,0 +1,143 @@
+#include "heatmap.h"
+#include <algorithm>
+#include <cmath>
+
+// Опорные цвета палитры (в духе inferno), между ними — линейная интерполяция
+static const sf::Color PALETTE_STOPS[] = {
+    sf::Color(0, 0, 4),
+    sf::Color(87, 16, 110),
+    sf::Color(188, 55, 84),
+    sf::Color(249, 142, 9),
+    sf::Color(252, 255, 164)
+};
+
+DensityHeatmap::DensityHeatmap(WorkerPool& pool, float world_half_size)
+    : pool(pool),
+      partials(pool.size()),
+      chunk_max(pool.size(), 0) {
+    const int stops = sizeof(PALETTE_STOPS) / sizeof(PALETTE_STOPS[0]);
+    for (int i = 0; i < 256; ++i) {
+        const float t = i / 255.0f * (stops - 1);
+        const int k = std::min(static_cast<int>(t), stops - 2);
+        const float f = t - k;
+        const sf::Color& a = PALETTE_STOPS[k];
+        const sf::Color& b = PALETTE_STOPS[k + 1];
+        palette[i] = sf::Color(static_cast<sf::Uint8>(a.r + (b.r - a.r) * f),
+                               static_cast<sf::Uint8>(a.g + (b.g - a.g) * f),
+                               static_cast<sf::Uint8>(a.b + (b.b - a.b) * f));
+    }
+
+    visits.width = VISIT_GRID_SIZE;
+    visits.height = VISIT_GRID_SIZE;
+    visits.bounds = sf::FloatRect(-world_half_size, -world_half_size, 2 * world_half_size, 2 * world_half_size);
+    visits.counts.assign(static_cast<size_t>(VISIT_GRID_SIZE) * VISIT_GRID_SIZE, 0);
+}
+
+// === Раскладка частиц по клеткам ===
+// Каждый поток пишет в свою частичную сетку, затем строки суммируются параллельно;
+// сумма сразу возвращает частичные сетки в ноль.
+void DensityHeatmap::bin(const ParticleEnsemble& particles, OccupancyGrid& grid, bool accumulate) {
+    const size_t cells = static_cast<size_t>(grid.width) * grid.height;
+    grid.counts.resize(cells);
+    const int chunks = pool.size();
+
+    const float left = grid.bounds.left;
+    const float top = grid.bounds.top;
+    const float scale_x = grid.width / grid.bounds.width;
+    const float scale_y = grid.height / grid.bounds.height;
+    const float* x = particles.x.data();
+    const float* y = particles.y.data();
+
+    pool.run([&](int index) {
+        std::vector<uint32_t>& partial = partials[index];
+        if (partial.size() < cells)
+            partial.resize(cells, 0);
+
+        const int begin = WorkerPool::chunk_begin(particles.count, index, chunks);
+        const int end = WorkerPool::chunk_begin(particles.count, index + 1, chunks);
+        for (int i = begin; i < end; ++i) {
+            const int cx = static_cast<int>(std::floor((x[i] - left) * scale_x));
+            const int cy = static_cast<int>(std::floor((y[i] - top) * scale_y));
+            if (static_cast<unsigned>(cx) < static_cast<unsigned>(grid.width) &&
+                static_cast<unsigned>(cy) < static_cast<unsigned>(grid.height))
+                ++partial[static_cast<size_t>(cy) * grid.width + cx];
+        }
+    });
+
+    pool.run([&](int index) {
+        const size_t begin = cells * index / chunks;
+        const size_t end = cells * (index + 1) / chunks;
+        uint32_t local_max = 0;
+        for (size_t c = begin; c < end; ++c) {
+            uint32_t sum = accumulate ? grid.counts[c] : 0;
+            for (int t = 0; t < chunks; ++t) {
+                sum += partials[t][c];
+                partials[t][c] = 0;
+            }
+            grid.counts[c] = sum;
+            local_max = std::max(local_max, sum);
+        }
+        chunk_max[index] = local_max;
+    });
+    grid.max_count = *std::max_element(chunk_max.begin(), chunk_max.end());
+}
+
+// Логарифмическая шкала: редкие клетки не теряются рядом с плотным центром
+void DensityHeatmap::colorize(const OccupancyGrid& grid, sf::Texture& texture) {
+    const size_t cells = static_cast<size_t>(grid.width) * grid.height;
+    pixels.resize(cells * 4);
+
+    const float norm = grid.max_count > 0 ? 255.0f / std::log1p(static_cast<float>(grid.max_count)) : 0.0f;
+    const int chunks = pool.size();
+    pool.run([&](int index) {
+        const size_t begin = cells * index / chunks;
+        const size_t end = cells * (index + 1) / chunks;
+        for (size_t c = begin; c < end; ++c) {
+            const uint32_t n = grid.counts[c];
+            const sf::Color color = palette[static_cast<int>(std::log1p(static_cast<float>(n)) * norm)];
+            pixels[4 * c]     = color.r;
+            pixels[4 * c + 1] = color.g;
+            pixels[4 * c + 2] = color.b;
+            pixels[4 * c + 3] = n > 0 ? 255 : 0; // пустые клетки прозрачны
+        }
+    });
+
+    if (texture.getSize().x != static_cast<unsigned>(grid.width) ||
+        texture.getSize().y != static_cast<unsigned>(grid.height))
+        texture.create(grid.width, grid.height);
+    texture.update(pixels.data());
+}
+
+void DensityHeatmap::draw_grid(sf::RenderTarget& target, const OccupancyGrid& grid, sf::Texture& texture) {
+    colorize(grid, texture);
+
+    sf::Sprite sprite(texture);
+    sprite.setPosition(grid.bounds.left, grid.bounds.top);
+    sprite.setScale(grid.bounds.width / grid.width, grid.bounds.height / grid.height);
+    target.draw(sprite);
+}
+
+void DensityHeatmap::draw_density(sf::RenderTarget& target, const ParticleEnsemble& particles, const sf::View& camera) {
+    const sf::Vector2u size = target.getSize();
+    density.width = std::max(1, static_cast<int>(size.x) / HEATMAP_CELL_PX);
+    density.height = std::max(1, static_cast<int>(size.y) / HEATMAP_CELL_PX);
+    density.bounds = sf::FloatRect(camera.getCenter().x - camera.getSize().x / 2.f,
+                                   camera.getCenter().y - camera.getSize().y / 2.f,
+                                   camera.getSize().x, camera.getSize().y);
+
+    bin(particles, density, false);
+    draw_grid(target, density, density_texture);
+}
+
+void DensityHeatmap::accumulate_visits(const ParticleEnsemble& particles) {
+    bin(particles, visits, true);
+}
+
+void DensityHeatmap::clear_visits() {
+    std::fill(visits.counts.begin(), visits.counts.end(), 0);
+    visits.max_count = 0;
+}
+
+void DensityHeatmap::draw_visits(sf::RenderTarget& target) {
+    draw_grid(target, visits, visits_texture);
+}
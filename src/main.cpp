@@ -4,13 +4,131 @@
 #include <ctime>
 #include <cstdlib>
 #include <string>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <algorithm>
 #include "types.h"
 #include "config.h"
 #include "menu.h"
 #include "simulation.h"
+#include "headless.h"
+#include "sweep.h"
+#include "checkpoint.h"
+#include "boundary.h"
+#include "profiler.h"
 
-int main() {
+static bool has_flag(int argc, char** argv, const char* flag) {
+    for (int i = 1; i < argc; ++i)
+        if (!strcmp(argv[i], flag))
+            return true;
+    return false;
+}
+
+// Значение после флага или nullptr, если флага нет
+static const char* flag_value(int argc, char** argv, const char* flag) {
+    for (int i = 1; i + 1 < argc; ++i)
+        if (!strcmp(argv[i], flag))
+            return argv[i + 1];
+    return nullptr;
+}
+
+int main(int argc, char** argv) {
     srand(static_cast<unsigned int>(time(0)));
+
+    Settings settings;
+    settings.particle_count = DEFAULT_PARTICLE_COUNT;
+    settings.mean_free_path = DEFAULT_STEP_SIZE;
+    settings.delay          = DEFAULT_DELAY;
+    settings.dimension      = DEFAULT_DIMENSION;
+    settings.boundary       = DEFAULT_BOUNDARY;
+    settings.domain_size    = DEFAULT_DOMAIN_SIZE;
+    settings.thread_count   = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, MAX_THREAD_COUNT);
+    settings.seed           = static_cast<unsigned>(rand() % 1000000);
+    settings.steps_per_frame = DEFAULT_STEPS_PER_FRAME;
+    settings.path_policy    = DEFAULT_PATH_POLICY;
+    settings.path_budget_mb = DEFAULT_PATH_BUDGET_MB;
+
+    OutputOptions output;
+    output.profile_path      = nullptr;
+    output.profile_dump      = nullptr;
+    output.trajectory_path   = nullptr;
+    output.trajectory_stride = DEFAULT_RECORD_STRIDE;
+    output.checkpoint_path     = nullptr;
+    output.checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL;
+    output.resume_path         = nullptr;
+    output.passage_radii       = nullptr;
+    output.passage_path        = nullptr;
+
+    if (has_flag(argc, argv, "--help")) {
+        print_headless_usage(argv[0]);
+        return 0;
+    }
+
+    // Серия прогонов по сетке параметров: --sweep grid.txt [-o summary.csv] [-j T] [--seed S]
+    if (has_flag(argc, argv, "--sweep")) {
+        SweepOptions options;
+        options.thread_count = settings.thread_count;
+        options.seed         = 0; // серия воспроизводима и без --seed
+        if (!parse_sweep_args(argc, argv, options)) {
+            print_headless_usage(argv[0]);
+            return -1;
+        }
+        return run_sweep(options);
+    }
+
+    // Пакетный режим без окна
+    if (has_flag(argc, argv, "--headless")) {
+        HeadlessOptions options;
+        options.settings     = settings;
+        options.steps        = MAX_STEPS;
+        options.output       = output;
+        options.fit_interval = DEFAULT_FIT_INTERVAL;
+        options.stop_ks      = 0.0;
+        options.gas_diameter = 0.0;
+        if (!parse_headless_args(argc, argv, options)) {
+            print_headless_usage(argv[0]);
+            return -1;
+        }
+        return run_headless(options);
+    }
+
+    // Число измерений окна: --dim 3 (то же поле есть в меню)
+    if (const char* dimension = flag_value(argc, argv, "--dim"))
+        settings.dimension = std::clamp(atoi(dimension), 1, MAX_DIMENSION);
+    // Граница области: --boundary periodic|reflecting|absorbing|circular [--domain SIZE]
+    if (const char* boundary = flag_value(argc, argv, "--boundary")) {
+        BoundaryKind kind;
+        if (!parse_boundary(boundary, kind)) {
+            fprintf(stderr, "Unknown boundary %s\n", boundary);
+            print_headless_usage(argv[0]);
+            return -1;
+        }
+        settings.boundary = kind;
+    }
+    if (const char* size = flag_value(argc, argv, "--domain"))
+        settings.domain_size = std::max(1, atoi(size));
+    // Покадровые замеры в файл: --profile frames.csv или --profile trace.json
+    output.profile_path = flag_value(argc, argv, "--profile");
+    // Запись траекторий: --record run.traj [--record-every K]
+    output.trajectory_path = flag_value(argc, argv, "--record");
+    if (const char* stride = flag_value(argc, argv, "--record-every"))
+        output.trajectory_stride = std::max(1, atoi(stride));
+    // Контрольные точки: --checkpoint run.ckpt [--checkpoint-every K], продолжение: --resume run.ckpt
+    output.checkpoint_path = flag_value(argc, argv, "--checkpoint");
+    if (const char* interval = flag_value(argc, argv, "--checkpoint-every"))
+        output.checkpoint_interval = std::max(1, atoi(interval));
+    output.resume_path = flag_value(argc, argv, "--resume");
+    // Времена первого достижения радиусов: --passage 50,100,200 (график — Tab)
+    output.passage_radii = flag_value(argc, argv, "--passage");
+    if (output.resume_path && !load_checkpoint_settings(output.resume_path, settings))
+        return -1;
+    // Кадр файла траекторий — все N частиц, а поглощение их выбрасывает
+    if (settings.boundary == BOUNDARY_ABSORBING && output.trajectory_path) {
+        fprintf(stderr, "--record cannot be combined with --boundary absorbing\n");
+        return -1;
+    }
+
     sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Random walks");
     window.setFramerateLimit(60);
 
@@ -20,19 +138,29 @@ int main() {
         return -1;
     }
 
-    Settings settings;
-    settings.particle_count = DEFAULT_PARTICLE_COUNT;
-    settings.mean_free_path = DEFAULT_STEP_SIZE;
-    settings.delay          = DEFAULT_DELAY;
+    // Замеры всех прогонов окна — в одном файле, по сессии на прогон
+    ProfileDump profile_dump;
+    if (output.profile_path && profile_dump.open(output.profile_path))
+        output.profile_dump = &profile_dump;
+
+    // Просмотр записи вместо новой симуляции: --replay run.traj
+    if (const char* replay_path = flag_value(argc, argv, "--replay"))
+        return run_replay(window, font, settings, replay_path, output);
 
     AppState state = MENU;
 
     while (window.isOpen()) {
         if (state == MENU) {
-            show_menu(window, font, settings);
+            // Продолжение с контрольной точки начинается сразу, без меню
+            if (!output.resume_path)
+                show_menu(window, font, settings);
             state = SIMULATION;
         } else if (state == SIMULATION) {
-            run_simulation(window, font, settings);
+            run_simulation(window, font, settings, output);
+            // Флаги относятся к первому прогону: новый прогон из меню не продолжает
+            // и не затирает его контрольную точку
+            output.resume_path = nullptr;
+            output.checkpoint_path = nullptr;
             state = MENU;
         }
     }
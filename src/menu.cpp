@@ -6,18 +6,27 @@
 #include <ctime>
 #include <cstdlib>
 #include <string>
+#include <algorithm>
 
 void show_menu(sf::RenderWindow& window, sf::Font& font, Settings& settings) {
     bool is_dark_theme = true;
     sf::RectangleShape background(sf::Vector2f(WINDOW_WIDTH, WINDOW_HEIGHT));
     background.setFillColor(is_dark_theme ? sf::Color(40, 40, 40) : sf::Color(230, 230, 230));
 
-    const int field_count = 3;
-    std::string labels[field_count] = {"N", "L (nm)", "T (mcs)"};
+    const int field_count = 9;
+    std::string labels[field_count] = {"N", "L (nm)", "T (mcs)", "Dim", "Threads", "Seed", "Steps/frame", "Path mode",
+                                       "Path MB"};
     std::string count_str = std::to_string(settings.particle_count);
     std::string size_str = std::to_string(settings.mean_free_path);
     std::string delay_str = std::to_string(settings.delay);
-    std::string* fields[field_count] = {&count_str, &size_str, &delay_str};
+    std::string dimension_str = std::to_string(settings.dimension);
+    std::string threads_str = std::to_string(settings.thread_count);
+    std::string seed_str = std::to_string(settings.seed);
+    std::string speed_str = std::to_string(settings.steps_per_frame);
+    std::string policy_str = std::to_string(settings.path_policy);
+    std::string budget_str = std::to_string(settings.path_budget_mb);
+    std::string* fields[field_count] = {&count_str, &size_str, &delay_str, &dimension_str, &threads_str, &seed_str,
+                                        &speed_str, &policy_str, &budget_str};
 
     sf::RectangleShape input_boxes[field_count];
     sf::Text input_texts[field_count];
@@ -56,6 +65,9 @@ void show_menu(sf::RenderWindow& window, sf::Font& font, Settings& settings) {
     sf::Text usage(
         "Usage:\n"
         "Enter - Start Simulation\n"
+        "Steps/frame 0 - as fast as possible\n"
+        "Dim 1/2/3 - number of dimensions\n"
+        "Path mode 0/1/2 - last K / every k-th / adaptive\n"
         "H - Hide/Show Controls\n"
         "T - Toggle Theme",
         font, 16
@@ -90,6 +102,12 @@ void show_menu(sf::RenderWindow& window, sf::Font& font, Settings& settings) {
                     settings.particle_count = std::max(1, atoi(count_str.c_str()));
                     settings.mean_free_path = atof(size_str.c_str());
                     settings.delay = atof(delay_str.c_str());
+                    settings.dimension = std::clamp(atoi(dimension_str.c_str()), 1, MAX_DIMENSION);
+                    settings.thread_count = std::clamp(atoi(threads_str.c_str()), 1, MAX_THREAD_COUNT);
+                    settings.seed = strtoul(seed_str.c_str(), nullptr, 10);
+                    settings.steps_per_frame = std::max(0, atoi(speed_str.c_str()));
+                    settings.path_policy = std::clamp(atoi(policy_str.c_str()), 0, 2);
+                    settings.path_budget_mb = std::max(0, atoi(budget_str.c_str()));
                     return;
                 }
 
@@ -0,0 +1,277 @@
+#include "moments.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static void kahan_add(double& sum, double& compensation, double value) {
+    const double y = value - compensation;
+    const double t = sum + y;
+    compensation = (t - sum) - y;
+    sum = t;
+}
+
+void MomentSums::add_block(const double* bx, const double* by, const double* bz,
+                           const double* bxx, const double* byy, const double* bzz, const double* br4) {
+    double sx = 0.0, sy = 0.0, sz = 0.0, sxx = 0.0, syy = 0.0, szz = 0.0, sr4 = 0.0;
+    for (int k = 0; k < MOMENT_LANES; ++k) {
+        sx += bx[k];
+        sy += by[k];
+        sz += bz[k];
+        sxx += bxx[k];
+        syy += byy[k];
+        szz += bzz[k];
+        sr4 += br4[k];
+    }
+    kahan_add(x, cx, sx);
+    kahan_add(y, cy, sy);
+    kahan_add(z, cz, sz);
+    kahan_add(xx, cxx, sxx);
+    kahan_add(yy, cyy, syy);
+    kahan_add(zz, czz, szz);
+    kahan_add(r4, cr4, sr4);
+}
+
+void MomentSums::add(const MomentSums& other) {
+    kahan_add(x, cx, other.x - other.cx);
+    kahan_add(y, cy, other.y - other.cy);
+    kahan_add(z, cz, other.z - other.cz);
+    kahan_add(xx, cxx, other.xx - other.cxx);
+    kahan_add(yy, cyy, other.yy - other.cyy);
+    kahan_add(zz, czz, other.zz - other.czz);
+    kahan_add(r4, cr4, other.r4 - other.cr4);
+}
+
+EnsembleMoments moments_from_sums(const MomentSums& sums, int count, int dimension, int step) {
+    EnsembleMoments m;
+    m.step = step;
+    m.count = count;
+    m.dimension = dimension;
+    if (count <= 0)
+        return m;
+
+    const double n = count;
+    m.mean_x = sums.x / n;
+    m.mean_y = sums.y / n;
+    m.mean_z = sums.z / n;
+    m.var_x = std::max(0.0, sums.xx / n - m.mean_x * m.mean_x);
+    m.var_y = std::max(0.0, sums.yy / n - m.mean_y * m.mean_y);
+    m.var_z = std::max(0.0, sums.zz / n - m.mean_z * m.mean_z);
+    m.mean_r_squared = (sums.xx + sums.yy + sums.zz) / n;
+    m.mean_r_fourth = sums.r4 / n;
+    return m;
+}
+
+// Вклад одной частицы в дорожку k; оси выше D не читаются и не складываются
+template <int D>
+static inline void accumulate_particle(const float* x, const float* y, const float* z, int j, int k,
+                                       double* bx, double* by, double* bz,
+                                       double* bxx, double* byy, double* bzz, double* br4) {
+    const double dx = x[j];
+    double r2 = dx * dx;
+    bx[k] += dx;
+    bxx[k] += dx * dx;
+    if constexpr (D >= 2) {
+        const double dy = y[j];
+        r2 += dy * dy;
+        by[k] += dy;
+        byy[k] += dy * dy;
+    }
+    if constexpr (D == 3) {
+        const double dz = z[j];
+        r2 += dz * dz;
+        bz[k] += dz;
+        bzz[k] += dz * dz;
+    }
+    br4[k] += r2 * r2;
+}
+
+template <int D>
+void accumulate_block(const float* x, const float* y, const float* z, int n, MomentSums& sums) {
+    double bx[MOMENT_LANES] = {}, by[MOMENT_LANES] = {}, bz[MOMENT_LANES] = {};
+    double bxx[MOMENT_LANES] = {}, byy[MOMENT_LANES] = {}, bzz[MOMENT_LANES] = {}, br4[MOMENT_LANES] = {};
+
+    int j = 0;
+    for (; j + MOMENT_LANES <= n; j += MOMENT_LANES) {
+        for (int k = 0; k < MOMENT_LANES; ++k)
+            accumulate_particle<D>(x, y, z, j + k, k, bx, by, bz, bxx, byy, bzz, br4);
+    }
+    for (int k = 0; j < n; ++j, ++k)
+        accumulate_particle<D>(x, y, z, j, k, bx, by, bz, bxx, byy, bzz, br4);
+    sums.add_block(bx, by, bz, bxx, byy, bzz, br4);
+}
+
+template void accumulate_block<1>(const float*, const float*, const float*, int, MomentSums&);
+template void accumulate_block<2>(const float*, const float*, const float*, int, MomentSums&);
+template void accumulate_block<3>(const float*, const float*, const float*, int, MomentSums&);
+
+template <int D>
+static void accumulate_range(const float* x, const float* y, const float* z, int begin, int end, MomentSums& sums) {
+    for (int i = begin; i < end; i += MOMENT_BLOCK)
+        accumulate_block<D>(x + i, y + i, z ? z + i : nullptr, std::min(MOMENT_BLOCK, end - i), sums);
+}
+
+void accumulate_moments(const ParticleEnsemble& particles, int begin, int end, MomentSums& sums) {
+    const float* x = particles.x.data();
+    const float* y = particles.y.data();
+    const float* z = particles.z_data();
+    switch (particles.dimension) {
+        case 1:  accumulate_range<1>(x, y, z, begin, end, sums); break;
+        case 3:  accumulate_range<3>(x, y, z, begin, end, sums); break;
+        default: accumulate_range<2>(x, y, z, begin, end, sums); break;
+    }
+}
+
+EnsembleMoments measure_moments(const ParticleEnsemble& particles, int step) {
+    MomentSums sums;
+    accumulate_moments(particles, 0, particles.count, sums);
+    return moments_from_sums(sums, particles.count, particles.dimension, step);
+}
+
+MomentHistory::MomentHistory() {
+    points.reserve(MOMENT_HISTORY_CAPACITY);
+}
+
+void MomentHistory::clear() {
+    points.clear();
+    stride_ = 1;
+}
+
+void MomentHistory::record(const EnsembleMoments& moments) {
+    if (moments.step % stride_ != 0)
+        return;
+
+    if (static_cast<int>(points.size()) == MOMENT_HISTORY_CAPACITY) {
+        // Оставляем точки с чётными номерами, шаг записи удваивается
+        const int kept = (MOMENT_HISTORY_CAPACITY + 1) / 2;
+        for (int k = 1; k < kept; ++k)
+            points[k] = points[2 * k];
+        points.resize(kept);
+        stride_ *= 2;
+        if (moments.step % stride_ != 0)
+            return;
+    }
+    points.push_back(moments);
+}
+
+MsdSeries::MsdSeries() : ring(MSD_RING_CAPACITY) {}
+
+void MsdSeries::clear() {
+    head = 0;
+    count = 0;
+    next_step = 1;
+    since_rebuild = 0;
+    sum_t = sum_m = sum_tt = sum_tm = 0.0;
+}
+
+void MsdSeries::add_sums(const MsdPoint& point, double sign) {
+    const double t = std::log(static_cast<double>(point.step));
+    const double m = std::log(point.msd);
+    sum_t  += sign * t;
+    sum_m  += sign * m;
+    sum_tt += sign * t * t;
+    sum_tm += sign * t * m;
+}
+
+void MsdSeries::rebuild_sums() {
+    sum_t = sum_m = sum_tt = sum_tm = 0.0;
+    for (int i = 0; i < count; ++i)
+        add_sums(at(i), 1.0);
+    since_rebuild = 0;
+}
+
+void MsdSeries::record(int step, double msd) {
+    // ln 0 не определён: начальное состояние в подгонку не попадает
+    if (step < next_step || msd <= 0.0)
+        return;
+    next_step = std::max(step + 1, static_cast<int>(std::ceil(step * MSD_LOG_RATIO)));
+
+    const MsdPoint point = {step, msd};
+    if (count == MSD_RING_CAPACITY) {
+        add_sums(ring[head], -1.0);
+        ring[head] = point;
+        head = (head + 1) % MSD_RING_CAPACITY;
+    } else {
+        ring[(head + count) % MSD_RING_CAPACITY] = point;
+        ++count;
+    }
+    add_sums(point, 1.0);
+
+    if (++since_rebuild == MSD_RING_CAPACITY)
+        rebuild_sums();
+}
+
+bool MsdSeries::fit(double delay, int dimension, double& alpha, double& diffusion) const {
+    if (count < 2)
+        return false;
+
+    const double n = count;
+    const double denominator = n * sum_tt - sum_t * sum_t;
+    if (denominator <= 0.0)
+        return false;
+
+    // ln⟨r²⟩ = α ln(step) + b; при t = step * delay: 2dD = e^b / delay^α
+    alpha = (n * sum_tm - sum_t * sum_m) / denominator;
+    const double intercept = (sum_m - alpha * sum_t) / n;
+    diffusion = std::exp(intercept - alpha * std::log(delay)) / (2.0 * dimension);
+    return true;
+}
+
+// === Снимки для контрольной точки ===
+template <typename T>
+static void put(std::vector<uint8_t>& out, const T* data, size_t n) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + n * sizeof(T));
+}
+
+template <typename T>
+static bool take(const uint8_t*& data, const uint8_t* end, T* out, size_t n) {
+    if (static_cast<size_t>(end - data) < n * sizeof(T))
+        return false;
+    memcpy(out, data, n * sizeof(T));
+    data += n * sizeof(T);
+    return true;
+}
+
+void MomentHistory::save(std::vector<uint8_t>& out) const {
+    const int32_t header[2] = {stride_, static_cast<int32_t>(points.size())};
+    put(out, header, 2);
+    put(out, points.data(), points.size());
+}
+
+bool MomentHistory::load(const uint8_t*& data, const uint8_t* end) {
+    int32_t header[2];
+    if (!take(data, end, header, 2) || header[0] <= 0 || header[1] < 0 || header[1] > MOMENT_HISTORY_CAPACITY)
+        return false;
+    points.resize(header[1]);
+    stride_ = header[0];
+    return take(data, end, points.data(), points.size());
+}
+
+void MsdSeries::save(std::vector<uint8_t>& out) const {
+    const int32_t header[3] = {count, next_step, since_rebuild};
+    const double sums[4] = {sum_t, sum_m, sum_tt, sum_tm};
+    put(out, header, 3);
+    put(out, sums, 4);
+    for (int i = 0; i < count; ++i)
+        put(out, &at(i), 1);
+}
+
+bool MsdSeries::load(const uint8_t*& data, const uint8_t* end) {
+    int32_t header[3];
+    double sums[4];
+    if (!take(data, end, header, 3) || !take(data, end, sums, 4) ||
+        header[0] < 0 || header[0] > MSD_RING_CAPACITY || header[2] < 0 || header[2] >= MSD_RING_CAPACITY)
+        return false;
+    // Точки кладутся с начала кольца: порядок вытеснения тот же, что и до сохранения
+    if (!take(data, end, ring.data(), header[0]))
+        return false;
+    head = 0;
+    count = header[0];
+    next_step = header[1];
+    since_rebuild = header[2];
+    sum_t  = sums[0];
+    sum_m  = sums[1];
+    sum_tt = sums[2];
+    sum_tm = sums[3];
+    return true;
+}
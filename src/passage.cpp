@@ -0,0 +1,235 @@
+#include "passage.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static const double PI = 3.14159265358979323846;
+// Членов ряда выживания; при малых t ряд не сходится за это число, но там S(t) = 1
+static const int SURVIVAL_TERMS = 200;
+
+// === Ряд выживания в d-мерном шаре радиуса R со стартом из центра ===
+// S(t) = Σ cₙ exp(-jₙ² D t / R²), jₙ — нули J_{d/2 - 1}:
+//   1D: jₙ = (n - ½)π, cₙ = 4(-1)^{n-1} / ((2n - 1)π)
+//   2D: jₙ — нули J₀,   cₙ = 2 / (jₙ J₁(jₙ))
+//   3D: jₙ = nπ,        cₙ = 2(-1)^{n+1}
+static void sphere_series(int dimension, double radius, double diffusion,
+                          std::vector<double>& coefficients, std::vector<double>& rates) {
+    coefficients.resize(SURVIVAL_TERMS);
+    rates.resize(SURVIVAL_TERMS);
+    for (int n = 1; n <= SURVIVAL_TERMS; ++n) {
+        const double sign = n % 2 ? 1.0 : -1.0;
+        double zero, c;
+        if (dimension == 1) {
+            zero = (n - 0.5) * PI;
+            c = 4.0 * sign / ((2 * n - 1) * PI);
+        } else if (dimension == 3) {
+            zero = n * PI;
+            c = 2.0 * sign;
+        } else {
+            // Ньютон от асимптотики Макмэхона; J₀' = -J₁
+            zero = (n - 0.25) * PI + 0.125 / ((n - 0.25) * PI);
+            for (int k = 0; k < 5; ++k)
+                zero += std::cyl_bessel_j(0.0, zero) / std::cyl_bessel_j(1.0, zero);
+            c = 2.0 / (zero * std::cyl_bessel_j(1.0, zero));
+        }
+        coefficients[n - 1] = c;
+        rates[n - 1] = zero * zero * diffusion / (radius * radius);
+    }
+}
+
+void PassageMonitor::configure(const std::vector<float>& radii, const Domain& domain, int dimension,
+                               float mean_free_path, int particle_count, int chunk_count, int max_steps) {
+    std::vector<float> sorted = radii;
+    std::sort(sorted.begin(), sorted.end());
+    radius_count = std::min(static_cast<int>(sorted.size()), MAX_PASSAGE_RADII);
+    const bool wall = domain.kind == BOUNDARY_ABSORBING;
+    target_count_ = radius_count + (wall ? 1 : 0);
+    count = particle_count;
+    bin_steps_ = std::max(1, (max_steps + PASSAGE_BINS - 1) / PASSAGE_BINS);
+
+    // Дисперсия по оси за шаг 2λ²/d = 2D: D = λ²/d на шаг
+    const double diffusion = static_cast<double>(mean_free_path) * mean_free_path / dimension;
+    for (int k = 0; k < radius_count; ++k) {
+        radii_[k] = sorted[k];
+        radius_sq[k] = sorted[k] * sorted[k];
+        sphere_series(dimension, radii_[k], diffusion, coefficients[k], rates[k]);
+        power[k] = 1;
+    }
+    // Ящик — d независимых отрезков [-L/2, L/2]
+    if (wall) {
+        sphere_series(1, 0.5 * domain.size, diffusion, coefficients[radius_count], rates[radius_count]);
+        power[radius_count] = dimension;
+    }
+
+    mask.assign(target_count_ > 0 ? particle_count : 0, 0);
+    chunk_counts.assign(static_cast<size_t>(std::max(chunk_count, 1)) * PASSAGE_COUNTER_STRIDE, 0);
+    histogram.assign(static_cast<size_t>(target_count_) * PASSAGE_BINS, 0);
+    reset();
+}
+
+void PassageMonitor::reset() {
+    std::fill(mask.begin(), mask.end(), 0);
+    std::fill(chunk_counts.begin(), chunk_counts.end(), 0);
+    std::fill(histogram.begin(), histogram.end(), 0);
+    std::fill(crossed_, crossed_ + MAX_PASSAGE_TARGETS, 0);
+    std::fill(time_sum, time_sum + MAX_PASSAGE_TARGETS, 0.0);
+    last_step = 0;
+}
+
+// Маска и счётчики обновляются без ветвлений: бит «дошла» ставится сравнением,
+// новые пересечения — то, чего в маске ещё не было. |r|² блока считается
+// один раз, дальше каждый радиус — отдельный проход по блоку. Проход всегда
+// на полные PASSAGE_BLOCK элементов: цикл без хвоста GCC векторизует и при -O2.
+template <int D>
+void PassageMonitor::observe(int chunk, const float* x, const float* y, const float* z, int first, int n) {
+    int* counters = chunk_counts.data() + static_cast<size_t>(chunk) * PASSAGE_COUNTER_STRIDE;
+    uint32_t* bits = mask.data() + first;
+    float    r_sq[PASSAGE_BLOCK];
+    uint32_t block_bits[PASSAGE_BLOCK];
+
+    for (int begin = 0; begin < n; begin += PASSAGE_BLOCK) {
+        const int m = std::min(PASSAGE_BLOCK, n - begin);
+        for (int i = 0; i < m; ++i) {
+            float sum = x[begin + i] * x[begin + i];
+            if constexpr (D >= 2)
+                sum += y[begin + i] * y[begin + i];
+            if constexpr (D == 3)
+                sum += z[begin + i] * z[begin + i];
+            r_sq[i] = sum;
+        }
+        // Хвост неполного блока — нулевой радиус, он не дойдёт ни до одного R
+        std::fill(r_sq + m, r_sq + PASSAGE_BLOCK, 0.0f);
+        std::copy(bits + begin, bits + begin + m, block_bits);
+
+        for (int k = 0; k < radius_count; ++k) {
+            const float limit = radius_sq[k];
+            const uint32_t bit = 1u << k;
+            uint32_t fresh = 0;
+            for (int i = 0; i < PASSAGE_BLOCK; ++i) {
+                const uint32_t hit = r_sq[i] >= limit ? bit : 0u;
+                fresh += (hit & ~block_bits[i]) >> k;
+                block_bits[i] |= hit;
+            }
+            counters[k] += fresh;
+        }
+        std::copy(block_bits, block_bits + m, bits + begin);
+    }
+}
+
+template void PassageMonitor::observe<1>(int, const float*, const float*, const float*, int, int);
+template void PassageMonitor::observe<2>(int, const float*, const float*, const float*, int, int);
+template void PassageMonitor::observe<3>(int, const float*, const float*, const float*, int, int);
+
+void PassageMonitor::record_step(int step, int absorbed) {
+    if (!enabled())
+        return;
+    last_step = step;
+    const int bin = std::min((step - 1) / bin_steps_, PASSAGE_BINS - 1);
+    const int chunks = static_cast<int>(chunk_counts.size()) / PASSAGE_COUNTER_STRIDE;
+
+    for (int k = 0; k < target_count_; ++k) {
+        long long fresh = 0;
+        if (is_wall(k)) {
+            fresh = absorbed;
+        } else {
+            for (int c = 0; c < chunks; ++c) {
+                fresh += chunk_counts[c * PASSAGE_COUNTER_STRIDE + k];
+                chunk_counts[c * PASSAGE_COUNTER_STRIDE + k] = 0;
+            }
+        }
+        histogram[k * PASSAGE_BINS + bin] += fresh;
+        crossed_[k] += fresh;
+        time_sum[k] += static_cast<double>(fresh) * step;
+    }
+}
+
+std::string PassageMonitor::target_name(int target) const {
+    if (is_wall(target))
+        return "wall";
+    char name[32];
+    snprintf(name, sizeof(name), "r%g", radii_[target]);
+    return name;
+}
+
+double PassageMonitor::empirical_cdf(int target, int bin) const {
+    long long total = 0;
+    for (int b = 0; b <= bin; ++b)
+        total += bin_count(target, b);
+    return count > 0 ? static_cast<double>(total) / count : 0.0;
+}
+
+double PassageMonitor::survival(int target, double step) const {
+    const std::vector<double>& c = coefficients[target];
+    const std::vector<double>& a = rates[target];
+    if (step <= 0.0 || c.empty())
+        return 1.0;
+    // Последний член ещё заметен — значит t много меньше R²/D и до границы никто не дошёл
+    if (a.back() * step < 30.0)
+        return 1.0;
+
+    double sum = 0.0;
+    for (size_t n = 0; n < c.size(); ++n) {
+        const double term = std::exp(-a[n] * step);
+        sum += c[n] * term;
+        if (term < 1e-15)
+            break;
+    }
+    sum = std::clamp(sum, 0.0, 1.0);
+    return std::pow(sum, power[target]);
+}
+
+double PassageMonitor::theory_cdf(int target, double step) const {
+    return 1.0 - survival(target, step);
+}
+
+double PassageMonitor::theory_mean(int target) const {
+    // Шар из центра: ⟨T⟩ = R² / (2dD) = R² / 2λ² при D = λ²/d
+    if (power[target] == 1) {
+        double mean = 0.0;
+        for (size_t n = 0; n < coefficients[target].size(); ++n)
+            mean += coefficients[target][n] / rates[target][n];
+        return mean;
+    }
+
+    // Ящик: ⟨T⟩ = ∫ S(t) dt трапециями с шагом в 1/200 времени самой медленной моды
+    const double h = 1.0 / (200.0 * rates[target][0]);
+    double mean = 0.5 * h;
+    for (double t = h;; t += h) {
+        const double s = survival(target, t);
+        mean += s * h;
+        if (s < 1e-10)
+            break;
+    }
+    return mean;
+}
+
+double PassageMonitor::ks_distance(int target) const {
+    const int bins = bins_used();
+    long long total = 0;
+    double distance = 0.0;
+    for (int b = 0; b < bins; ++b) {
+        total += bin_count(target, b);
+        const double end_step = std::min((b + 1) * bin_steps_, last_step);
+        const double empirical = count > 0 ? static_cast<double>(total) / count : 0.0;
+        distance = std::max(distance, std::fabs(empirical - theory_cdf(target, end_step)));
+    }
+    return distance;
+}
+
+bool parse_passage_radii(const char* text, std::vector<float>& radii) {
+    radii.clear();
+    const char* p = text;
+    while (*p) {
+        while (*p == ' ' || *p == ',')
+            ++p;
+        if (!*p)
+            break;
+        char* end;
+        const double value = strtod(p, &end);
+        if (end == p || value <= 0.0)
+            return false;
+        radii.push_back(static_cast<float>(value));
+        p = end;
+    }
+    return !radii.empty() && static_cast<int>(radii.size()) <= MAX_PASSAGE_RADII;
+}
@@ -0,0 +1,163 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstring>
+
+static const char* const PHASE_NAMES[PROFILE_PHASE_COUNT] = {
+    "frame", "events", "snapshot", "step", "stats", "grid",
+    "paths", "particles", "heatmap", "plot", "hud", "display"
+};
+
+const char* profile_phase_name(ProfilePhase phase) {
+    return PHASE_NAMES[phase];
+}
+
+FrameProfiler::FrameProfiler()
+    : origin(Clock::now()),
+      frame_start(origin) {
+    for (auto& samples : history)
+        samples.assign(PROFILE_WINDOW, 0.0f);
+    std::fill(current, current + PROFILE_PHASE_COUNT, 0.0);
+    scratch.reserve(PROFILE_WINDOW);
+    overlay.setCharacterSize(14);
+}
+
+ProfileDump::~ProfileDump() {
+    if (!file_)
+        return;
+    if (trace_)
+        fprintf(file_, "\n]\n");
+    fclose(file_);
+}
+
+bool ProfileDump::open(const char* path) {
+    file_ = fopen(path, "w");
+    if (!file_) {
+        fprintf(stderr, "Error while opening %s\n", path);
+        return false;
+    }
+
+    const size_t length = strlen(path);
+    trace_ = length >= 5 && !strcmp(path + length - 5, ".json");
+    if (trace_) {
+        fprintf(file_, "[\n");
+    } else {
+        fprintf(file_, "session,frame");
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+            fprintf(file_, ",%s_ms", PHASE_NAMES[phase]);
+        fprintf(file_, "\n");
+    }
+    return true;
+}
+
+int ProfileDump::begin_session() {
+    ++sessions;
+    if (trace_)
+        fprintf(file_, "%s{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"session %d\"}}",
+                separator(), sessions, sessions);
+    return sessions;
+}
+
+const char* ProfileDump::separator() {
+    const char* result = first ? "" : ",\n";
+    first = false;
+    return result;
+}
+
+void FrameProfiler::attach_dump(ProfileDump* dump) {
+    this->dump = dump && dump->file() ? dump : nullptr;
+    if (!this->dump)
+        return;
+    session = this->dump->begin_session();
+    origin = this->dump->origin();
+}
+
+void FrameProfiler::begin_frame() {
+    frame_start = Clock::now();
+    std::fill(current, current + PROFILE_PHASE_COUNT, 0.0);
+    events.clear();
+}
+
+void FrameProfiler::add(ProfilePhase phase, Clock::time_point start, double seconds) {
+    current[phase] += seconds;
+    if (dump && dump->trace())
+        events.push_back(TraceEvent{phase,
+                                    std::chrono::duration<double, std::micro>(start - origin).count(),
+                                    seconds * 1e6});
+}
+
+void FrameProfiler::add(ProfilePhase phase, double seconds) {
+    current[phase] += seconds;
+}
+
+void FrameProfiler::end_frame() {
+    add(PROFILE_FRAME, frame_start, std::chrono::duration<double>(Clock::now() - frame_start).count());
+
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+        history[phase][cursor] = static_cast<float>(current[phase] * 1e3);
+    cursor = (cursor + 1) % PROFILE_WINDOW;
+    filled = std::min(filled + 1, PROFILE_WINDOW);
+
+    if (dump)
+        write_dump();
+    ++frame_index;
+}
+
+// === Выгрузка кадра: строка CSV или события Chrome trace ===
+// Фазы окна идут в поток 1 процесса-сессии как "X"-события, шаги из потока симуляции —
+// счётчиком, потому что для них известна только суммарная длительность.
+void FrameProfiler::write_dump() {
+    FILE* file = dump->file();
+    if (!dump->trace()) {
+        fprintf(file, "%d,%lld", session, frame_index);
+        for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase)
+            fprintf(file, ",%.4f", current[phase] * 1e3);
+        fprintf(file, "\n");
+        return;
+    }
+
+    for (const TraceEvent& event : events)
+        fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.1f, \"dur\": %.1f, \"pid\": %d, \"tid\": 1}",
+                dump->separator(), PHASE_NAMES[event.phase], event.start_us, event.duration_us, session);
+    const double frame_us = std::chrono::duration<double, std::micro>(frame_start - origin).count();
+    fprintf(file, "%s{\"name\": \"step_ms\", \"ph\": \"C\", \"ts\": %.1f, \"pid\": %d, \"args\": {\"step\": %.4f}}",
+            dump->separator(), frame_us, session, current[PROFILE_STEP] * 1e3);
+}
+
+double FrameProfiler::average_ms(ProfilePhase phase) const {
+    if (filled == 0)
+        return 0.0;
+    double sum = 0.0;
+    for (int i = 0; i < filled; ++i)
+        sum += history[phase][i];
+    return sum / filled;
+}
+
+double FrameProfiler::p99_ms(ProfilePhase phase) const {
+    if (filled == 0)
+        return 0.0;
+    scratch.assign(history[phase].begin(), history[phase].begin() + filled);
+    const int rank = std::min(filled - 1, static_cast<int>(0.99 * filled));
+    std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.end());
+    return scratch[rank];
+}
+
+// === Таблица фаз: среднее и p99 за окно ===
+void FrameProfiler::draw_overlay(sf::RenderTarget& target, const sf::Font& font,
+                                 sf::Vector2f position, sf::Color color) {
+    char line[64];
+    overlay_string = "phase        avg ms   p99 ms\n";
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+        const ProfilePhase p = static_cast<ProfilePhase>(phase);
+        snprintf(line, sizeof(line), "%-10s %8.2f %8.2f\n", PHASE_NAMES[phase], average_ms(p), p99_ms(p));
+        overlay_string += line;
+    }
+    const double frame_ms = average_ms(PROFILE_FRAME);
+    snprintf(line, sizeof(line), "fps %.1f", frame_ms > 0 ? 1000.0 / frame_ms : 0.0);
+    overlay_string += line;
+
+    overlay.setFont(font);
+    overlay.setString(overlay_string);
+    overlay.setFillColor(color);
+    overlay.setPosition(position);
+    target.draw(overlay);
+}
@@ -0,0 +1,156 @@
+#include "radial_stats.h"
+#include <algorithm>
+#include <cmath>
+
+template <bool HasZ>
+static inline float radius_squared(const float* x, const float* y, const float* z, int i) {
+    float r_sq = x[i] * x[i] + y[i] * y[i];
+    if constexpr (HasZ)
+        r_sq += z[i] * z[i];
+    return r_sq;
+}
+
+template <bool HasZ>
+static float bin_radii(const float* x, const float* y, const float* z, int count, int* bins) {
+    // Первый проход: граница диапазона (⟨r²⟩ считает ядро шага, см. moments.h)
+    float max_sq = 0.0f;
+    for (int i = 0; i < count; ++i)
+        max_sq = std::max(max_sq, radius_squared<HasZ>(x, y, z, i));
+    max_sq = std::max(max_sq, 1e-10f);
+
+    // Второй проход: раскладываем r² по бинам
+    const float inv_width = RADIAL_FINE_BINS / max_sq;
+    for (int i = 0; i < count; ++i) {
+        const float r_sq = radius_squared<HasZ>(x, y, z, i);
+        const int bin = std::min(static_cast<int>(r_sq * inv_width), RADIAL_FINE_BINS - 1);
+        ++bins[bin];
+    }
+    return max_sq;
+}
+
+void RadialHistogram::build(const float* x, const float* y, const float* z, int count) {
+    total = count;
+    cumulative.assign(RADIAL_FINE_BINS, 0);
+
+    int* bins = cumulative.data();
+    max_r_squared = z ? bin_radii<true>(x, y, z, count, bins) : bin_radii<false>(x, y, z, count, bins);
+
+    for (int i = 1; i < RADIAL_FINE_BINS; ++i)
+        bins[i] += bins[i - 1];
+}
+
+float RadialHistogram::max_radius() const {
+    return std::sqrt(max_r_squared);
+}
+
+float RadialHistogram::count_within(float r) const {
+    if (total == 0 || r <= 0.0f)
+        return 0.0f;
+
+    const float r_sq = r * r;
+    if (r_sq >= max_r_squared)
+        return static_cast<float>(total);
+
+    const float pos = r_sq * RADIAL_FINE_BINS / max_r_squared;
+    const int bin = std::min(static_cast<int>(pos), RADIAL_FINE_BINS - 1);
+    const float below = bin > 0 ? static_cast<float>(cumulative[bin - 1]) : 0.0f;
+    return below + (pos - bin) * (cumulative[bin] - below);
+}
+
+static const double PI = 3.14159265358979323846;
+
+double chi_cdf(int dimension, double r, double sigma_sq) {
+    if (r <= 0.0 || sigma_sq <= 0.0)
+        return 0.0;
+    const double u = r / std::sqrt(2.0 * sigma_sq);
+    switch (dimension) {
+        case 1:  return std::erf(u);
+        case 3:  return std::erf(u) - 2.0 / std::sqrt(PI) * u * std::exp(-u * u);
+        default: return 1.0 - std::exp(-u * u);
+    }
+}
+
+double chi_pdf(int dimension, double r, double sigma_sq) {
+    if (r < 0.0 || sigma_sq <= 0.0)
+        return 0.0;
+    const double gauss = std::exp(-r * r / (2.0 * sigma_sq));
+    switch (dimension) {
+        case 1:  return std::sqrt(2.0 / (PI * sigma_sq)) * gauss;
+        case 3:  return std::sqrt(2.0 / PI) * r * r / (sigma_sq * std::sqrt(sigma_sq)) * gauss;
+        default: return r / sigma_sq * gauss;
+    }
+}
+
+// Минимум ожидаемых частиц в ячейке χ²; меньшие бины сливаются с соседями
+static const double CHI2_MIN_EXPECTED = 5.0;
+
+// Q(λ) = 2 Σ (-1)^(j-1) exp(-2 j² λ²) — хвост распределения Колмогорова
+static double kolmogorov_q(double lambda) {
+    if (lambda < 0.2)
+        return 1.0;
+    double sum = 0.0;
+    for (int j = 1; j <= 100; ++j) {
+        const double term = std::exp(-2.0 * j * j * lambda * lambda);
+        sum += (j % 2 ? term : -term);
+        if (term < 1e-12)
+            break;
+    }
+    return std::clamp(2.0 * sum, 0.0, 1.0);
+}
+
+GoodnessOfFit chi_goodness(const RadialHistogram& histogram, int dimension, double sigma_sq) {
+    GoodnessOfFit fit = {0.0, 1.0, 0.0, 0};
+    if (histogram.total == 0 || histogram.cumulative.empty() || sigma_sq <= 0.0)
+        return fit;
+
+    const double n = histogram.total;
+    const double bin_width = static_cast<double>(histogram.max_r_squared) / RADIAL_FINE_BINS;
+    // Бины равны по r², поэтому у Рэлея exp(-r²/2σ²) на границах — геометрическая прогрессия
+    const double ratio = std::exp(-bin_width / (2.0 * sigma_sq));
+    double survival = 1.0;  // 1 - F на текущей границе
+    double previous_cdf = 0.0;
+    int previous_count = 0;
+
+    double group_observed = 0.0, group_expected = 0.0;
+    double last_observed = 0.0, last_expected = 0.0;
+    int cells = 0;
+    for (int i = 0; i < RADIAL_FINE_BINS; ++i) {
+        if (dimension == 2)
+            survival *= ratio;
+        else
+            survival = 1.0 - chi_cdf(dimension, std::sqrt(bin_width * (i + 1)), sigma_sq);
+        const double cdf = 1.0 - survival;
+        const int count = histogram.cumulative[i];
+
+        fit.ks = std::max(fit.ks, std::fabs(count / n - cdf));
+
+        group_observed += count - previous_count;
+        group_expected += n * (cdf - previous_cdf);
+        // Хвост за последним бином уходит в последнюю ячейку
+        if (i == RADIAL_FINE_BINS - 1)
+            group_expected += n * survival;
+        const bool last_bin = i == RADIAL_FINE_BINS - 1;
+        if (last_bin && group_expected < CHI2_MIN_EXPECTED && cells > 0) {
+            // Недобравшая хвостовая ячейка сливается с предыдущей
+            fit.chi2 -= (last_observed - last_expected) * (last_observed - last_expected) / last_expected;
+            group_observed += last_observed;
+            group_expected += last_expected;
+            --cells;
+        }
+        if ((group_expected >= CHI2_MIN_EXPECTED || last_bin) && group_expected > 0.0) {
+            const double diff = group_observed - group_expected;
+            fit.chi2 += diff * diff / group_expected;
+            ++cells;
+            last_observed = group_observed;
+            last_expected = group_expected;
+            group_observed = group_expected = 0.0;
+        }
+        previous_cdf = cdf;
+        previous_count = count;
+    }
+
+    fit.dof = std::max(cells - 1, 1);
+    const double root_n = std::sqrt(n);
+    fit.ks_p = kolmogorov_q((root_n + 0.12 + 0.11 / root_n) * fit.ks);
+    return fit;
+}
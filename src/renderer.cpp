@@ -0,0 +1,157 @@
+#include "renderer.h"
+#include <algorithm>
+
+ParticleRenderer::ParticleRenderer()
+    : dots(sf::Quads),
+      use_buffer(sf::VertexBuffer::isAvailable()),
+      path_buffer(sf::Lines, sf::VertexBuffer::Stream) {
+}
+
+static inline void write_dot(sf::Vertex* quad, sf::Vector2f p, float radius, sf::Color color) {
+    quad[0] = sf::Vertex(sf::Vector2f(p.x - radius, p.y - radius), color);
+    quad[1] = sf::Vertex(sf::Vector2f(p.x + radius, p.y - radius), color);
+    quad[2] = sf::Vertex(sf::Vector2f(p.x + radius, p.y + radius), color);
+    quad[3] = sf::Vertex(sf::Vector2f(p.x - radius, p.y + radius), color);
+}
+
+// === Все частицы одним вызовом draw ===
+void ParticleRenderer::draw_particles(sf::RenderTarget& target, const ParticleEnsemble& particles,
+                                      float radius, sf::Color color, Projection projection) {
+    dots.resize(static_cast<size_t>(particles.count) * 4);
+
+    const float* x = particles.x.data();
+    const float* y = particles.y.data();
+    const float* z = particles.z_data();
+    // Проекция выбирается один раз на кадр, а не на каждую частицу
+    if (projection == PROJECTION_ISOMETRIC) {
+        for (int i = 0; i < particles.count; ++i)
+            write_dot(&dots[static_cast<size_t>(i) * 4], isometric(x[i], y[i], z ? z[i] : 0.0f), radius, color);
+    } else {
+        for (int i = 0; i < particles.count; ++i)
+            write_dot(&dots[static_cast<size_t>(i) * 4], sf::Vector2f(x[i], y[i]), radius, color);
+    }
+    target.draw(dots);
+}
+
+// Ячеек на кольцо отрезков: окно из capacity точек задевает не больше
+// capacity / step + 2 отрезков, ещё одна — запас на отрезок, выпавший из окна
+static int cells_for(int capacity, int step) {
+    return capacity / step + 3;
+}
+
+// Наименьшее прореживание, при котором пути всех частиц помещаются в буфер; 0 — не помещаются
+static int decimation_step(int particles, int capacity) {
+    for (int step = 1; step <= capacity; ++step) {
+        if (2LL * particles * cells_for(capacity, step) <= MAX_PATH_VERTICES)
+            return step;
+    }
+    return 0;
+}
+
+static long long ceil_div(long long a, long long b) {
+    return (a + b - 1) / b;
+}
+
+int ParticleRenderer::write_segment(const TrajectoryStore& paths, long long k) {
+    const long long last  = paths.stored() - 1;
+    const long long first = paths.stored() - paths.path_length();
+    const long long from  = std::max((k - 1) * path_step, first);
+    const long long to    = std::min(k * path_step, last);
+    const int cell = static_cast<int>(k % path_cells);
+    if (from >= to) {
+        clear_segment(cell);
+        return cell;
+    }
+
+    const int slot_a = paths.slot_of(from);
+    const int slot_b = paths.slot_of(to);
+    sf::Vertex* v = &path_vertices[static_cast<size_t>(cell) * path_particles * 2];
+    for (int i = 0; i < path_particles; ++i) {
+        const PathPoint& a = paths.at_slot(i, slot_a);
+        const PathPoint& b = paths.at_slot(i, slot_b);
+        const sf::Color color = particle_color(i);
+        v[2 * i]     = sf::Vertex(sf::Vector2f(a.x, a.y), color);
+        v[2 * i + 1] = sf::Vertex(sf::Vector2f(b.x, b.y), color);
+    }
+    return cell;
+}
+
+// Вырожденный отрезок нулевой длины: ячейка занята, но рисовать нечего
+void ParticleRenderer::clear_segment(int cell) {
+    sf::Vertex* v = &path_vertices[static_cast<size_t>(cell) * path_particles * 2];
+    for (int i = 0; i < path_particles * 2; ++i)
+        v[i] = sf::Vertex(v[i & ~1].position, sf::Color::Transparent);
+}
+
+void ParticleRenderer::upload_segment(int cell) {
+    if (!use_buffer)
+        return;
+    const size_t offset = static_cast<size_t>(cell) * path_particles * 2;
+    path_buffer.update(&path_vertices[offset], static_cast<size_t>(path_particles) * 2,
+                       static_cast<unsigned>(offset));
+}
+
+void ParticleRenderer::rebuild_paths(const TrajectoryStore& paths) {
+    for (int cell = 0; cell < path_cells; ++cell)
+        clear_segment(cell);
+
+    const long long last  = paths.stored() - 1;
+    const long long first = paths.stored() - paths.path_length();
+    for (long long k = first / path_step + 1; k <= ceil_div(last, path_step); ++k)
+        write_segment(paths, k);
+
+    if (use_buffer)
+        path_buffer.update(path_vertices.data());
+}
+
+// === Траектории всех частиц одним вызовом draw ===
+void ParticleRenderer::draw_paths(sf::RenderTarget& target, const TrajectoryStore& paths) {
+    if (!paths.enabled())
+        return;
+
+    const int capacity = paths.capacity();
+    const int particles = paths.particles();
+    const int step = decimation_step(particles, capacity);
+    if (particles <= 0 || step == 0)
+        return;
+
+    // Смена раскладки (сброс, прореживание) или слишком большой отрыв — полная перестройка
+    const bool layout_changed = capacity != path_capacity || particles != path_particles || step != path_step;
+    if (layout_changed) {
+        path_capacity = capacity;
+        path_particles = particles;
+        path_step = step;
+        path_cells = cells_for(capacity, step);
+        path_vertices.assign(static_cast<size_t>(path_cells) * particles * 2, sf::Vertex());
+        if (use_buffer && !path_buffer.create(path_vertices.size()))
+            use_buffer = false;
+    }
+
+    const long long stored = paths.stored();
+    const long long first = stored - paths.path_length();
+    if (layout_changed || paths.revision() != seen_revision || stored - seen_stored > capacity) {
+        rebuild_paths(paths);
+    } else if (stored > seen_stored) {
+        // Выпавшие из окна отрезки гасим до записи новых: их ячейки могут быть уже заняты новыми
+        for (long long k = seen_first / path_step + 1; k <= first / path_step; ++k) {
+            const int cell = static_cast<int>(k % path_cells);
+            clear_segment(cell);
+            upload_segment(cell);
+        }
+        // Отрезок с прошлой свежей точкой дотягивается до новой, дальше — новые отрезки
+        for (long long k = std::max(1LL, ceil_div(seen_stored - 1, path_step)); k <= ceil_div(stored - 1, path_step); ++k)
+            upload_segment(write_segment(paths, k));
+        // У старейшего отрезка сдвинулось начало
+        if (first != seen_first)
+            upload_segment(write_segment(paths, first / path_step + 1));
+    }
+    seen_revision = paths.revision();
+    seen_stored = stored;
+    seen_first = first;
+
+    const size_t count = static_cast<size_t>(path_cells) * path_particles * 2;
+    if (use_buffer)
+        target.draw(path_buffer, 0, count);
+    else
+        target.draw(path_vertices.data(), count, sf::Lines);
+}
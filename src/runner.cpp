@@ -0,0 +1,209 @@
+#include "runner.h"
+#include "config.h"
+#include <chrono>
+#include <cstdio>
+
+SimulationRunner::SimulationRunner(const Settings& settings, const OutputOptions& output)
+    : settings(settings),
+      particles(settings.particle_count, settings.dimension),
+      engine(settings.thread_count, settings.seed, settings.mean_free_path, domain_from_settings(settings)),
+      steps_per_frame_(settings.steps_per_frame) {
+    for (auto& buffer : buffers)
+        buffer.particles = ParticleEnsemble(settings.particle_count, settings.dimension);
+
+    // Координаты, шаг, генераторы, история моментов и MSD(t) с контрольной точки;
+    // траектории начинаются с неё заново
+    bool observables_resumed = false;
+    if (output.resume_path) {
+        Checkpoint resume;
+        if (load_checkpoint(output.resume_path, resume) && resume.particles.x.size() == particles.x.size() &&
+            resume.particles.dimension == particles.dimension && engine.restore_streams(resume.streams)) {
+            particles = std::move(resume.particles);
+            current_step = resume.step;
+            observables_resumed = unpack_observables(resume.observables, history, msd);
+            if (!observables_resumed) {
+                history.clear();
+                msd.clear();
+                fprintf(stderr, "Checkpoint %s has no MSD history, the fit starts at step %d\n",
+                        output.resume_path, current_step);
+            }
+        } else {
+            fprintf(stderr, "Checkpoint %s does not match the settings, starting over\n", output.resume_path);
+        }
+    }
+    checkpoints.configure(output.checkpoint_path, output.checkpoint_interval);
+    checkpoint_step = current_step;
+
+    // Маска «уже дошла» не сохраняется в контрольной точке, поэтому после продолжения монитора нет
+    std::vector<float> passage_radii;
+    if (output.passage_radii && !parse_passage_radii(output.passage_radii, passage_radii)) {
+        fprintf(stderr, "--passage expects 1 to %d positive radii separated by commas\n", MAX_PASSAGE_RADII);
+    } else if (!passage_radii.empty() && current_step > 0) {
+        fprintf(stderr, "First-passage monitor is off after --resume\n");
+    } else if (!passage_radii.empty()) {
+        passage.configure(passage_radii, engine.domain(), settings.dimension,
+                          static_cast<float>(settings.mean_free_path), particles.count, engine.thread_count(),
+                          MAX_STEPS);
+        engine.attach_passage(&passage);
+    }
+
+    // Поглощение сдвигает номера частиц, и траектория по номеру перестала бы быть одной частицей
+    const size_t path_budget = engine.domain().kind == BOUNDARY_ABSORBING
+                                   ? 0 : static_cast<size_t>(settings.path_budget_mb) << 20;
+    paths.configure(settings.particle_count, static_cast<PathPolicy>(settings.path_policy),
+                    path_budget, MAX_STEPS + 1);
+    paths.record(particles.x.data(), particles.y.data(), current_step);
+    moments = measure_moments(particles, current_step);
+    if (!observables_resumed) {
+        history.record(moments);
+        msd.record(current_step, moments.mean_r_squared);
+    }
+
+    if (output.trajectory_path && writer.open(output.trajectory_path, settings, output.trajectory_stride))
+        writer.submit(current_step, particles);
+
+    publish();
+    worker = std::thread(&SimulationRunner::loop, this);
+}
+
+SimulationRunner::~SimulationRunner() {
+    {
+        std::lock_guard<std::mutex> lock(control_mutex);
+        stopping = true;
+    }
+    control_cv.notify_all();
+    worker.join();
+
+    // Выход в меню не теряет прогресс: последняя точка пишется сразу
+    if (current_step != checkpoint_step)
+        checkpoints.save_now(settings, current_step, engine, particles, history, msd);
+}
+
+void SimulationRunner::grant_frame() {
+    {
+        std::lock_guard<std::mutex> lock(control_mutex);
+        // Бюджет не копится: если поток не успел, лишние шаги не догоняются
+        frame_budget = steps_per_frame_.load();
+    }
+    control_cv.notify_all();
+}
+
+void SimulationRunner::set_steps_per_frame(int steps) {
+    steps_per_frame_ = steps;
+    control_cv.notify_all();
+}
+
+void SimulationRunner::set_paused(bool paused) {
+    paused_ = paused;
+    control_cv.notify_all();
+}
+
+void SimulationRunner::request_reset() {
+    reset_requested = true;
+    control_cv.notify_all();
+}
+
+const Snapshot& SimulationRunner::latest() {
+    if (middle.load(std::memory_order_acquire) & SNAPSHOT_FRESH)
+        read_index = middle.exchange(read_index, std::memory_order_acq_rel) & 3;
+    return buffers[read_index];
+}
+
+void SimulationRunner::publish() {
+    Snapshot& snapshot = buffers[write_index];
+    snapshot.step = current_step;
+    snapshot.particles.count = particles.count;
+    snapshot.particles.x = particles.x;
+    snapshot.particles.y = particles.y;
+    snapshot.particles.z = particles.z;
+    snapshot.moments = moments;
+    write_index = middle.exchange(write_index | SNAPSHOT_FRESH, std::memory_order_acq_rel) & 3;
+}
+
+// Вызывается под control_mutex
+bool SimulationRunner::can_step() const {
+    if (stopping || reset_requested)
+        return true;
+    if (paused_ || current_step >= MAX_STEPS)
+        return false;
+    return steps_per_frame_ == 0 || frame_budget > 0;
+}
+
+void SimulationRunner::loop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(control_mutex);
+            control_cv.wait(lock, [this] { return can_step(); });
+            if (stopping)
+                return;
+            if (steps_per_frame_ > 0 && !reset_requested)
+                --frame_budget;
+        }
+
+        if (reset_requested.exchange(false)) {
+            {
+                std::lock_guard<std::mutex> lock(paths_mutex_);
+                particles.reset();
+                paths.clear();
+                paths.record(particles.x.data(), particles.y.data(), 0);
+            }
+            engine.reset();
+            current_step = 0;
+            checkpoint_step = 0;
+            moments = measure_moments(particles, 0);
+            {
+                std::lock_guard<std::mutex> lock(history_mutex_);
+                history.clear();
+                history.record(moments);
+                msd.clear();
+                passage.reset();
+            }
+            // Файл всегда описывает текущий прогон: после сброса пишется заново
+            if (writer.restart())
+                writer.submit(0, particles);
+            publish();
+            continue;
+        }
+
+        auto step_start = std::chrono::steady_clock::now();
+        const int alive = particles.count;
+        engine.step(particles);
+        current_step++;
+        moments = engine.moments(current_step);
+        {
+            std::lock_guard<std::mutex> lock(history_mutex_);
+            history.record(moments);
+            msd.record(current_step, moments.mean_r_squared);
+            passage.record_step(current_step, alive - particles.count);
+        }
+        if (paths.enabled()) {
+            // Арену читает окно, а пишет только этот поток: прореживание идёт
+            // без блокировки, под ней остаётся копия готовой половины
+            paths.prepare_simplify();
+            std::lock_guard<std::mutex> lock(paths_mutex_);
+            paths.record(particles.x.data(), particles.y.data(), current_step);
+        }
+        writer.submit(current_step, particles);
+        if (checkpoints.due(current_step)) {
+            checkpoints.save_async(settings, current_step, engine, particles, history, msd);
+            checkpoint_step = current_step;
+        }
+        step_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - step_start).count();
+
+        if (steps_per_frame_ > 0)
+            sf::sleep(sf::microseconds(settings.delay));
+
+        // Копируем координаты, только если окно уже забрало прошлый снимок,
+        // или перед тем как поток встанет в ожидание — так последний шаг
+        // всегда виден, а в режиме «как можно быстрее» копий не больше, чем кадров
+        bool reader_caught_up = !(middle.load(std::memory_order_acquire) & SNAPSHOT_FRESH);
+        bool about_to_idle;
+        {
+            std::lock_guard<std::mutex> lock(control_mutex);
+            about_to_idle = !can_step();
+        }
+        if (reader_caught_up || about_to_idle)
+            publish();
+    }
+}
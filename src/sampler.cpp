@@ -0,0 +1,439 @@
+#include "sampler.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAMPLER_X86 1
+#include <immintrin.h>
+#endif
+
+// === Константы полиномов (Cephes) ===
+static const float LOG_SQRTHF = 0.707106781186547524f;
+static const float LOG_P[9] = {
+     7.0376836292E-2f, -1.1514610310E-1f,  1.1676998740E-1f,
+    -1.2420140846E-1f,  1.4249322787E-1f, -1.6668057665E-1f,
+     2.0000714765E-1f, -2.4999993993E-1f,  3.3333331174E-1f
+};
+static const float LOG_Q1 = -2.12194440e-4f;
+static const float LOG_Q2 =  0.693359375f;
+
+static const float SIN_P0 = -1.9515295891E-4f;
+static const float SIN_P1 =  8.3321608736E-3f;
+static const float SIN_P2 = -1.6666654611E-1f;
+static const float COS_P0 =  2.443315711809948E-5f;
+static const float COS_P1 = -1.388731625493765E-3f;
+static const float COS_P2 =  4.166664568298827E-2f;
+static const float HALF_PI = 1.57079632679489661923f;
+static const float INV_2_24 = 1.0f / 16777216.0f;
+
+// === Скалярная ветка (эталон для векторных) ===
+static inline uint32_t rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+static inline uint32_t next_lane(SamplerState& st, int lane) {
+    uint32_t* s0 = &st.s[0][lane];
+    uint32_t* s1 = &st.s[1][lane];
+    uint32_t* s2 = &st.s[2][lane];
+    uint32_t* s3 = &st.s[3][lane];
+    const uint32_t result = *s0 + *s3;
+    const uint32_t t = *s1 << 9;
+    *s2 ^= *s0;
+    *s3 ^= *s1;
+    *s1 ^= *s2;
+    *s0 ^= *s3;
+    *s2 ^= t;
+    *s3 = rotl(*s3, 11);
+    return result;
+}
+
+// Равномерное в (0, 1]: старшие 24 бита + 1
+static inline float uniform_open(uint32_t u) {
+    return static_cast<float>(static_cast<int32_t>((u >> 8) + 1)) * INV_2_24;
+}
+
+static inline float log_scalar(float x) {
+    int32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    int32_t e = (bits >> 23) - 126;
+    int32_t mbits = (bits & 0x007fffff) | 0x3f000000;
+    float m;
+    std::memcpy(&m, &mbits, sizeof(m));
+
+    float t = 0.0f;
+    if (m < LOG_SQRTHF) {
+        e -= 1;
+        t = m;
+    }
+    m = m - 1.0f;
+    m = m + t;
+
+    const float z = m * m;
+    float y = LOG_P[0];
+    for (int i = 1; i < 9; ++i)
+        y = y * m + LOG_P[i];
+    y = y * m;
+    y = y * z;
+
+    const float fe = static_cast<float>(e);
+    y = y + fe * LOG_Q1;
+    y = y - 0.5f * z;
+    float r = m + y;
+    r = r + fe * LOG_Q2;
+    return r;
+}
+
+// cos и sin угла 2πu для u из [0, 1)
+static inline void sincos_turn_scalar(float u, float& c_out, float& s_out) {
+    const float v = u * 4.0f;
+    const int32_t q = static_cast<int32_t>(v + 0.5f);
+    const float theta = (v - static_cast<float>(q)) * HALF_PI;
+    const float z = theta * theta;
+
+    float s = ((SIN_P0 * z + SIN_P1) * z + SIN_P2) * z * theta + theta;
+    float c = ((COS_P0 * z + COS_P1) * z + COS_P2) * z * z - 0.5f * z + 1.0f;
+
+    if (q & 1) {
+        float tmp = s;
+        s = c;
+        c = tmp;
+    }
+    if ((q + 1) & 2) c = -c;
+    if (q & 2)       s = -s;
+
+    c_out = c;
+    s_out = s;
+}
+
+static void exponential_scalar(SamplerState& st, float* out, size_t n, float mean) {
+    const float neg_mean = -mean;
+    for (size_t i = 0; i < n; i += SAMPLER_LANES) {
+        for (int l = 0; l < SAMPLER_LANES; ++l)
+            out[i + l] = neg_mean * log_scalar(uniform_open(next_lane(st, l)));
+    }
+}
+
+static void gaussian_scalar(SamplerState& st, float* a, float* b, size_t n) {
+    for (size_t i = 0; i < n; i += SAMPLER_LANES) {
+        for (int l = 0; l < SAMPLER_LANES; ++l) {
+            const float u1 = uniform_open(next_lane(st, l));
+            const float u2 = uniform_open(next_lane(st, l)) - INV_2_24;
+            const float r = std::sqrt(-2.0f * log_scalar(u1));
+            float c, s;
+            sincos_turn_scalar(u2, c, s);
+            a[i + l] = r * c;
+            b[i + l] = r * s;
+        }
+    }
+}
+
+#ifdef SAMPLER_X86
+
+// === SSE2: восемь дорожек как две половины по четыре ===
+static inline __m128i next_sse2(__m128i* s) {
+    const __m128i result = _mm_add_epi32(s[0], s[3]);
+    const __m128i t = _mm_slli_epi32(s[1], 9);
+    s[2] = _mm_xor_si128(s[2], s[0]);
+    s[3] = _mm_xor_si128(s[3], s[1]);
+    s[1] = _mm_xor_si128(s[1], s[2]);
+    s[0] = _mm_xor_si128(s[0], s[3]);
+    s[2] = _mm_xor_si128(s[2], t);
+    s[3] = _mm_or_si128(_mm_slli_epi32(s[3], 11), _mm_srli_epi32(s[3], 21));
+    return result;
+}
+
+static inline __m128 uniform_open_sse2(__m128i u) {
+    const __m128i k = _mm_add_epi32(_mm_srli_epi32(u, 8), _mm_set1_epi32(1));
+    return _mm_mul_ps(_mm_cvtepi32_ps(k), _mm_set1_ps(INV_2_24));
+}
+
+static inline __m128 log_sse2(__m128 x) {
+    const __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_srai_epi32(bits, 23), _mm_set1_epi32(126));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                             _mm_set1_epi32(0x3f000000)));
+
+    const __m128 mask = _mm_cmplt_ps(m, _mm_set1_ps(LOG_SQRTHF));
+    e = _mm_add_epi32(e, _mm_castps_si128(mask)); // маска = -1 там, где m < sqrt(1/2)
+    const __m128 t = _mm_and_ps(mask, m);
+    m = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+    m = _mm_add_ps(m, t);
+
+    const __m128 z = _mm_mul_ps(m, m);
+    __m128 y = _mm_set1_ps(LOG_P[0]);
+    for (int i = 1; i < 9; ++i)
+        y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(LOG_P[i]));
+    y = _mm_mul_ps(y, m);
+    y = _mm_mul_ps(y, z);
+
+    const __m128 fe = _mm_cvtepi32_ps(e);
+    y = _mm_add_ps(y, _mm_mul_ps(fe, _mm_set1_ps(LOG_Q1)));
+    y = _mm_sub_ps(y, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+    __m128 r = _mm_add_ps(m, y);
+    r = _mm_add_ps(r, _mm_mul_ps(fe, _mm_set1_ps(LOG_Q2)));
+    return r;
+}
+
+static inline void sincos_turn_sse2(__m128 u, __m128& c_out, __m128& s_out) {
+    const __m128 v = _mm_mul_ps(u, _mm_set1_ps(4.0f));
+    const __m128i q = _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+    const __m128 theta = _mm_mul_ps(_mm_sub_ps(v, _mm_cvtepi32_ps(q)), _mm_set1_ps(HALF_PI));
+    const __m128 z = _mm_mul_ps(theta, theta);
+
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_P0), z), _mm_set1_ps(SIN_P1));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SIN_P2));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), theta), theta);
+
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_P0), z), _mm_set1_ps(COS_P1));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COS_P2));
+    c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+    c = _mm_sub_ps(c, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+    c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+    const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    const __m128 cs = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+    const __m128 sn = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    const __m128i c_sign = _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30);
+    const __m128i s_sign = _mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30);
+
+    c_out = _mm_xor_ps(cs, _mm_castsi128_ps(c_sign));
+    s_out = _mm_xor_ps(sn, _mm_castsi128_ps(s_sign));
+}
+
+static void exponential_sse2(SamplerState& st, float* out, size_t n, float mean) {
+    const __m128 neg_mean = _mm_set1_ps(-mean);
+    for (int half = 0; half < 2; ++half) {
+        __m128i s[4];
+        for (int k = 0; k < 4; ++k)
+            s[k] = _mm_load_si128(reinterpret_cast<const __m128i*>(&st.s[k][half * 4]));
+
+        for (size_t i = 0; i < n; i += SAMPLER_LANES) {
+            const __m128 u = uniform_open_sse2(next_sse2(s));
+            _mm_storeu_ps(out + i + half * 4, _mm_mul_ps(neg_mean, log_sse2(u)));
+        }
+
+        for (int k = 0; k < 4; ++k)
+            _mm_store_si128(reinterpret_cast<__m128i*>(&st.s[k][half * 4]), s[k]);
+    }
+}
+
+static void gaussian_sse2(SamplerState& st, float* a, float* b, size_t n) {
+    for (int half = 0; half < 2; ++half) {
+        __m128i s[4];
+        for (int k = 0; k < 4; ++k)
+            s[k] = _mm_load_si128(reinterpret_cast<const __m128i*>(&st.s[k][half * 4]));
+
+        for (size_t i = 0; i < n; i += SAMPLER_LANES) {
+            const __m128 u1 = uniform_open_sse2(next_sse2(s));
+            const __m128 u2 = _mm_sub_ps(uniform_open_sse2(next_sse2(s)), _mm_set1_ps(INV_2_24));
+            const __m128 r = _mm_sqrt_ps(_mm_mul_ps(_mm_set1_ps(-2.0f), log_sse2(u1)));
+            __m128 c, sn;
+            sincos_turn_sse2(u2, c, sn);
+            _mm_storeu_ps(a + i + half * 4, _mm_mul_ps(r, c));
+            _mm_storeu_ps(b + i + half * 4, _mm_mul_ps(r, sn));
+        }
+
+        for (int k = 0; k < 4; ++k)
+            _mm_store_si128(reinterpret_cast<__m128i*>(&st.s[k][half * 4]), s[k]);
+    }
+}
+
+// === AVX2: все восемь дорожек в одном регистре ===
+// FMA намеренно не используется: результат должен совпадать со скалярной веткой.
+#define SAMPLER_AVX2_FN __attribute__((target("avx2")))
+
+SAMPLER_AVX2_FN static inline __m256i next_avx2(__m256i* s) {
+    const __m256i result = _mm256_add_epi32(s[0], s[3]);
+    const __m256i t = _mm256_slli_epi32(s[1], 9);
+    s[2] = _mm256_xor_si256(s[2], s[0]);
+    s[3] = _mm256_xor_si256(s[3], s[1]);
+    s[1] = _mm256_xor_si256(s[1], s[2]);
+    s[0] = _mm256_xor_si256(s[0], s[3]);
+    s[2] = _mm256_xor_si256(s[2], t);
+    s[3] = _mm256_or_si256(_mm256_slli_epi32(s[3], 11), _mm256_srli_epi32(s[3], 21));
+    return result;
+}
+
+SAMPLER_AVX2_FN static inline __m256 uniform_open_avx2(__m256i u) {
+    const __m256i k = _mm256_add_epi32(_mm256_srli_epi32(u, 8), _mm256_set1_epi32(1));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(k), _mm256_set1_ps(INV_2_24));
+}
+
+SAMPLER_AVX2_FN static inline __m256 log_avx2(__m256 x) {
+    const __m256i bits = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srai_epi32(bits, 23), _mm256_set1_epi32(126));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                                   _mm256_set1_epi32(0x3f000000)));
+
+    const __m256 mask = _mm256_cmp_ps(m, _mm256_set1_ps(LOG_SQRTHF), _CMP_LT_OQ);
+    e = _mm256_add_epi32(e, _mm256_castps_si256(mask));
+    const __m256 t = _mm256_and_ps(mask, m);
+    m = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+    m = _mm256_add_ps(m, t);
+
+    const __m256 z = _mm256_mul_ps(m, m);
+    __m256 y = _mm256_set1_ps(LOG_P[0]);
+    for (int i = 1; i < 9; ++i)
+        y = _mm256_add_ps(_mm256_mul_ps(y, m), _mm256_set1_ps(LOG_P[i]));
+    y = _mm256_mul_ps(y, m);
+    y = _mm256_mul_ps(y, z);
+
+    const __m256 fe = _mm256_cvtepi32_ps(e);
+    y = _mm256_add_ps(y, _mm256_mul_ps(fe, _mm256_set1_ps(LOG_Q1)));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+    __m256 r = _mm256_add_ps(m, y);
+    r = _mm256_add_ps(r, _mm256_mul_ps(fe, _mm256_set1_ps(LOG_Q2)));
+    return r;
+}
+
+SAMPLER_AVX2_FN static inline void sincos_turn_avx2(__m256 u, __m256& c_out, __m256& s_out) {
+    const __m256 v = _mm256_mul_ps(u, _mm256_set1_ps(4.0f));
+    const __m256i q = _mm256_cvttps_epi32(_mm256_add_ps(v, _mm256_set1_ps(0.5f)));
+    const __m256 theta = _mm256_mul_ps(_mm256_sub_ps(v, _mm256_cvtepi32_ps(q)), _mm256_set1_ps(HALF_PI));
+    const __m256 z = _mm256_mul_ps(theta, theta);
+
+    __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_P0), z), _mm256_set1_ps(SIN_P1));
+    s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(SIN_P2));
+    s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), theta), theta);
+
+    __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_P0), z), _mm256_set1_ps(COS_P1));
+    c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(COS_P2));
+    c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+    c = _mm256_sub_ps(c, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+    c = _mm256_add_ps(c, _mm256_set1_ps(1.0f));
+
+    const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    const __m256 cs = _mm256_blendv_ps(c, s, swap);
+    const __m256 sn = _mm256_blendv_ps(s, c, swap);
+    const __m256i c_sign = _mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30);
+    const __m256i s_sign = _mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30);
+
+    c_out = _mm256_xor_ps(cs, _mm256_castsi256_ps(c_sign));
+    s_out = _mm256_xor_ps(sn, _mm256_castsi256_ps(s_sign));
+}
+
+SAMPLER_AVX2_FN static void exponential_avx2(SamplerState& st, float* out, size_t n, float mean) {
+    __m256i s[4];
+    for (int k = 0; k < 4; ++k)
+        s[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(st.s[k]));
+
+    const __m256 neg_mean = _mm256_set1_ps(-mean);
+    for (size_t i = 0; i < n; i += SAMPLER_LANES) {
+        const __m256 u = uniform_open_avx2(next_avx2(s));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(neg_mean, log_avx2(u)));
+    }
+
+    for (int k = 0; k < 4; ++k)
+        _mm256_store_si256(reinterpret_cast<__m256i*>(st.s[k]), s[k]);
+}
+
+SAMPLER_AVX2_FN static void gaussian_avx2(SamplerState& st, float* a, float* b, size_t n) {
+    __m256i s[4];
+    for (int k = 0; k < 4; ++k)
+        s[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(st.s[k]));
+
+    for (size_t i = 0; i < n; i += SAMPLER_LANES) {
+        const __m256 u1 = uniform_open_avx2(next_avx2(s));
+        const __m256 u2 = _mm256_sub_ps(uniform_open_avx2(next_avx2(s)), _mm256_set1_ps(INV_2_24));
+        const __m256 r = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), log_avx2(u1)));
+        __m256 c, sn;
+        sincos_turn_avx2(u2, c, sn);
+        _mm256_storeu_ps(a + i, _mm256_mul_ps(r, c));
+        _mm256_storeu_ps(b + i, _mm256_mul_ps(r, sn));
+    }
+
+    for (int k = 0; k < 4; ++k)
+        _mm256_store_si256(reinterpret_cast<__m256i*>(st.s[k]), s[k]);
+}
+
+#endif // SAMPLER_X86
+
+// === Выбор ветки ===
+SamplerIsa detect_sampler_isa() {
+#ifdef SAMPLER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SAMPLER_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SAMPLER_SSE2;
+#endif
+    return SAMPLER_SCALAR;
+}
+
+const char* sampler_isa_name(SamplerIsa isa) {
+    switch (isa) {
+        case SAMPLER_AVX2: return "avx2";
+        case SAMPLER_SSE2: return "sse2";
+        default:           return "scalar";
+    }
+}
+
+static void exponential_kernel(SamplerIsa isa, SamplerState& st, float* out, size_t n, float mean) {
+#ifdef SAMPLER_X86
+    if (isa == SAMPLER_AVX2) { exponential_avx2(st, out, n, mean); return; }
+    if (isa == SAMPLER_SSE2) { exponential_sse2(st, out, n, mean); return; }
+#endif
+    (void)isa;
+    exponential_scalar(st, out, n, mean);
+}
+
+static void gaussian_kernel(SamplerIsa isa, SamplerState& st, float* a, float* b, size_t n) {
+#ifdef SAMPLER_X86
+    if (isa == SAMPLER_AVX2) { gaussian_avx2(st, a, b, n); return; }
+    if (isa == SAMPLER_SSE2) { gaussian_sse2(st, a, b, n); return; }
+#endif
+    (void)isa;
+    gaussian_scalar(st, a, b, n);
+}
+
+// === BatchSampler ===
+static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+BatchSampler::BatchSampler(SamplerIsa isa) : isa(isa) {
+    seed(0, 0);
+}
+
+void BatchSampler::seed(uint64_t seed, uint64_t stream) {
+    uint64_t sm = seed ^ (stream * 0xd1342543de82ef95ULL);
+    for (int l = 0; l < SAMPLER_LANES; ++l) {
+        for (int k = 0; k < 4; k += 2) {
+            const uint64_t v = splitmix64(sm);
+            state.s[k][l]     = static_cast<uint32_t>(v);
+            state.s[k + 1][l] = static_cast<uint32_t>(v >> 32);
+        }
+        // Нулевое состояние у xoshiro запрещено
+        if ((state.s[0][l] | state.s[1][l] | state.s[2][l] | state.s[3][l]) == 0)
+            state.s[0][l] = 1;
+    }
+}
+
+void BatchSampler::fill_exponential(float* out, size_t n, float mean) {
+    const size_t full = n - n % SAMPLER_LANES;
+    if (full > 0)
+        exponential_kernel(isa, state, out, full, mean);
+
+    if (full < n) {
+        alignas(32) float tail[SAMPLER_LANES];
+        exponential_kernel(isa, state, tail, SAMPLER_LANES, mean);
+        std::memcpy(out + full, tail, (n - full) * sizeof(float));
+    }
+}
+
+void BatchSampler::fill_gaussian(float* a, float* b, size_t n) {
+    const size_t full = n - n % SAMPLER_LANES;
+    if (full > 0)
+        gaussian_kernel(isa, state, a, b, full);
+
+    if (full < n) {
+        alignas(32) float tail_a[SAMPLER_LANES];
+        alignas(32) float tail_b[SAMPLER_LANES];
+        gaussian_kernel(isa, state, tail_a, tail_b, SAMPLER_LANES);
+        std::memcpy(a + full, tail_a, (n - full) * sizeof(float));
+        std::memcpy(b + full, tail_b, (n - full) * sizeof(float));
+    }
+}
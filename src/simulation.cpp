@@ -4,500 +4,680 @@
 #include <ctime>
 #include <cstdlib>
 #include <algorithm>
-#include <random>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
 #include "simulation.h"
 #include "config.h"
 #include "types.h"
+#include "boundary.h"
+#include "ensemble.h"
+#include "runner.h"
+#include "stats.h"
+#include "moments.h"
+#include "passage.h"
+#include "chart.h"
+#include "renderer.h"
+#include "heatmap.h"
+#include "profiler.h"
+#include "trajectory_reader.h"
+
+// === Подписи делений ===
+static std::string format_integer(float value) {
+    return std::to_string(int(value));
+}
+
+static std::string format_fraction(float value) {
+    return std::to_string(value).substr(0, 3);
+}
 
-// === Глобальные переменные для хранения истории графика ===
-std::vector<std::pair<float, float>> rayleigh_history;    // {r, cdf}
-std::vector<std::pair<float, int>>    histogram_history;  // {r, count}
+static std::string format_density(float value) {
+    return value > 0.00001f ? std::to_string(value).substr(0, 7) : "0";
+}
+
+static std::string format_decade(float value) {
+    return "1e" + std::to_string(static_cast<int>(std::lround(value)));
+}
 
-// === Обновление истории данных ===
-void update_histogram_data(const std::vector<Particle>& particles,
-                           float mean_free_path,
-                           int current_step) {
-    histogram_history.clear();
-    rayleigh_history.clear();
+// Область графиков в окне
+static sf::FloatRect chart_area() {
+    return sf::FloatRect(80.f, 80.f, WINDOW_WIDTH - 160.f, WINDOW_HEIGHT - 160.f);
+}
 
-    const int BIN_COUNT = 100;
+// === График CDF ===
+// Бирюзовая — накопленная доля частиц, фиолетовая — CDF χ-распределения (в 2D — Рэлея),
+// зелёная и жёлтая отметки — теоретический R и экспериментальный R'.
+void update_cdf_chart(Chart& chart, EnsembleStats& stats) {
+    // Эмпирическая и теоретическая CDF считаются лениво в EnsembleStats
+    const RadialCurve& curve = stats.cdf();
+    const std::vector<float>& histogram_radii = curve.radii;
+    const std::vector<float>& hit_fractions = curve.empirical;
+    const float mean_free_path = stats.mean_free_path();
+    const int current_step = stats.step();
+    const float sigma_sq = stats.sigma_squared();
+
+    // Граница оси округляется, чтобы подписи не пересобирались каждый шаг
+    ChartAxis x_axis = {0.0f, Chart::nice_ceiling(curve.max_radius), 10, format_integer};
+    ChartAxis y_axis = {0.0f, 1.0f, 10, format_fraction};
+    chart.set_axes(x_axis, y_axis);
+    chart.set_curve(0, histogram_radii.data(), hit_fractions.data(), CURVE_POINT_COUNT, sf::Color::Cyan);
+    chart.set_curve(1, histogram_radii.data(), curve.theory.data(), CURVE_POINT_COUNT, sf::Color::Magenta);
+
+    // === Теоретический RMS радиус ===
+    float theoretical_R = mean_free_path * sqrt(2 * current_step);
+    float theoretical_N = static_cast<float>(chi_cdf(stats.dimension(), theoretical_R, sigma_sq));
 
-    // Вычисляем расстояния и сортируем
-    std::vector<float> distances;
-    for (const auto& p : particles) {
-        distances.push_back(std::sqrt(p.position.x * p.position.x + p.position.y * p.position.y));
+    // === Экспериментальный RMS радиус R' и N(R') по экспериментальной CDF ===
+    float R_prime = stats.rms_radius();
+    float N_of_R_prime = 0.0f;
+    for (size_t i = 0; i < histogram_radii.size(); ++i) {
+        if (histogram_radii[i] >= R_prime) {
+            N_of_R_prime = hit_fractions[i];
+            break;
+        }
+    }
+    if (N_of_R_prime == 0.0f && !hit_fractions.empty()) {
+        N_of_R_prime = hit_fractions.back();
     }
-    std::sort(distances.begin(), distances.end());
 
-    float max_radius = mean_free_path * sqrt(2 * current_step);
-    if (max_radius < 1e-5f) max_radius = 1e-5f;
+    chart.clear_marks();
+    chart.add_span(0.0f, theoretical_R, theoretical_N, sf::Color::Green);
+    chart.add_span(0.0f, R_prime, N_of_R_prime, sf::Color::Yellow);
+
+    chart.set_note(0, "R = " + std::to_string(theoretical_R).substr(0, 5),
+                   sf::Vector2f(WINDOW_WIDTH - 150, 120), 14, sf::Color::Green);
+    chart.set_note(1, "N(R) = " + std::to_string(theoretical_N).substr(0, 5),
+                   sf::Vector2f(WINDOW_WIDTH - 150, 140), 14, sf::Color::Green);
+    chart.set_note(2, "R' = " + std::to_string(R_prime).substr(0, 5),
+                   sf::Vector2f(WINDOW_WIDTH - 150, 180), 14, sf::Color::Yellow);
+    chart.set_note(3, "N(R') = " + std::to_string(N_of_R_prime).substr(0, 5),
+                   sf::Vector2f(WINDOW_WIDTH - 150, 200), 14, sf::Color::Yellow);
+
+    // Расстояние Колмогорова–Смирнова до теоретической CDF
+    const GoodnessOfFit& fit = stats.goodness();
+    char ks_line[64];
+    snprintf(ks_line, sizeof(ks_line), "KS = %.4f (p = %.3f)", fit.ks, fit.ks_p);
+    chart.set_note(4, ks_line, sf::Vector2f(WINDOW_WIDTH - 150, 240), 14, sf::Color::White);
+}
+
+// === График PDF ===
+// Бирюзовая — плотность по радиусу, фиолетовая — PDF χ-распределения, справа сверху — пики обеих.
+void update_pdf_chart(Chart& chart, EnsembleStats& stats) {
+    // Плотность по радиусу и теоретическая PDF считаются лениво в EnsembleStats
+    const RadialCurve& curve = stats.pdf();
+    const std::vector<float>& histogram_radii = curve.radii;
+    const std::vector<float>& empirical_pdf = curve.empirical;
+    const std::vector<float>& pdf_values = curve.theory;
 
-    // σ^2 = λ² * N
-    float sigma_sq = mean_free_path * mean_free_path * current_step;
-    if (sigma_sq <= 1e-5f) sigma_sq = 1e-5f;
+    // === Найдём максимумы для масштабирования ===
+    float max_empirical = !empirical_pdf.empty() ? *std::max_element(empirical_pdf.begin(), empirical_pdf.end()) : 0.1f;
+    float max_theoretical = !pdf_values.empty() ? *std::max_element(pdf_values.begin(), pdf_values.end()) : 0.1f;
+    float y_max = std::max(max_empirical, max_theoretical);
+    if (y_max < 1e-5f) y_max = 1e-5f;
 
-    for (int i = 0; i < BIN_COUNT; ++i) {
-        float r = max_radius * i / (BIN_COUNT - 1);
+    ChartAxis x_axis = {0.0f, Chart::nice_ceiling(curve.max_radius), 10, format_integer};
+    ChartAxis y_axis = {0.0f, Chart::nice_ceiling(y_max), 10, format_density};
+    chart.set_axes(x_axis, y_axis);
+    chart.set_curve(0, histogram_radii.data(), empirical_pdf.data(), CURVE_POINT_COUNT, sf::Color::Cyan);
+    chart.set_curve(1, histogram_radii.data(), pdf_values.data(), CURVE_POINT_COUNT, sf::Color::Magenta);
 
-        // Подсчёт числа частиц до радиуса r
-        size_t count = std::upper_bound(distances.begin(), distances.end(), r) - distances.begin();
-        histogram_history.emplace_back(r, static_cast<int>(count));
+    // === Пики теоретической и экспериментальной PDF ===
+    auto max_it = std::max_element(pdf_values.begin(), pdf_values.end());
+    float r_peak_theory = histogram_radii[std::distance(pdf_values.begin(), max_it)];
+    auto max_it_exp = std::max_element(empirical_pdf.begin(), empirical_pdf.end());
+    float r_peak_experiment = histogram_radii[std::distance(empirical_pdf.begin(), max_it_exp)];
+
+    chart.set_note(0, "Theory Peak: " + std::to_string(r_peak_theory).substr(0, 5),
+                   sf::Vector2f(WINDOW_WIDTH - 220, 20), 16, sf::Color::Green);
+    chart.set_note(1, "Experimental Peak: " + std::to_string(r_peak_experiment).substr(0, 5),
+                   sf::Vector2f(WINDOW_WIDTH - 220, 50), 16, sf::Color::Yellow);
+
+    // χ² по бинам гистограммы против теоретической PDF
+    const GoodnessOfFit& fit = stats.goodness();
+    char chi2_line[64];
+    if (fit.dof > 0)
+        snprintf(chi2_line, sizeof(chi2_line), "chi2/dof = %.3f (dof %d)", fit.chi2 / fit.dof, fit.dof);
+    else
+        snprintf(chi2_line, sizeof(chi2_line), "chi2/dof = n/a (no particles)");
+    chart.set_note(2, chi2_line, sf::Vector2f(WINDOW_WIDTH - 220, 80), 16, sf::Color::White);
+}
 
-        // Теоретическое значение CDF Рэлея
-        float cdf = 1.0f - exp(-r * r / (2 * sigma_sq));
-        rayleigh_history.emplace_back(r, cdf);
+// === График MSD(t) в логарифмическом масштабе ===
+// Бирюзовая — точки кольца MsdSeries, фиолетовая — теория ⟨r²⟩ = 2λ²N,
+// жёлтая — подгонка ⟨r²⟩ = 2d D t^α по тем же точкам. Оси — log10, деления по декадам.
+// xs, ys — рабочие массивы под логарифмы точек. Вызывать под мьютексом истории.
+void update_msd_chart(Chart& chart, const MsdSeries& msd, float mean_free_path, int delay, int dimension,
+                      std::vector<float>& xs, std::vector<float>& ys) {
+    if (msd.size() < 2) {
+        for (int i = 0; i < 3; ++i)
+            chart.set_curve(i, nullptr, nullptr, 0, sf::Color::White);
+        for (int i = 0; i < 3; ++i)
+            chart.set_note(i, "", sf::Vector2f(), 16, sf::Color::White);
+        return;
+    }
+
+    const double lambda_sq = static_cast<double>(mean_free_path) * mean_free_path;
+    const int first_step = msd.at(0).step;
+    const int last_step = msd.at(msd.size() - 1).step;
+
+    xs.resize(msd.size());
+    ys.resize(msd.size());
+    float min_y = std::log10(static_cast<float>(2.0 * lambda_sq * first_step));
+    float max_y = std::log10(static_cast<float>(2.0 * lambda_sq * last_step));
+    for (int i = 0; i < msd.size(); ++i) {
+        xs[i] = std::log10(static_cast<float>(msd.at(i).step));
+        ys[i] = std::log10(static_cast<float>(msd.at(i).msd));
+        min_y = std::min(min_y, ys[i]);
+        max_y = std::max(max_y, ys[i]);
+    }
+
+    // === Диапазоны по целым декадам ===
+    ChartAxis x_axis = {std::floor(xs.front()), 0.0f, 1, format_decade};
+    x_axis.max = std::max(x_axis.min + 1.0f, std::ceil(xs.back()));
+    x_axis.ticks = static_cast<int>(x_axis.max - x_axis.min);
+    ChartAxis y_axis = {std::floor(min_y), 0.0f, 1, format_decade};
+    y_axis.max = std::max(y_axis.min + 1.0f, std::ceil(max_y));
+    y_axis.ticks = static_cast<int>(y_axis.max - y_axis.min);
+    chart.set_axes(x_axis, y_axis);
+
+    chart.set_curve(0, xs.data(), ys.data(), msd.size(), sf::Color::Cyan);
+
+    const float ends_x[] = {xs.front(), xs.back()};
+    const float theory_y[] = {std::log10(static_cast<float>(2.0 * lambda_sq * first_step)),
+                              std::log10(static_cast<float>(2.0 * lambda_sq * last_step))};
+    chart.set_curve(1, ends_x, theory_y, 2, sf::Color::Magenta);
+    chart.set_note(2, "Theory: 2 l^2 N", sf::Vector2f(WINDOW_WIDTH - 220, 70), 16, sf::Color::Magenta);
+
+    // === Подгонка 2d D t^α ===
+    double alpha = 0.0, D_fit = 0.0;
+    if (msd.fit(delay, dimension, alpha, D_fit)) {
+        auto fitted = [&](double step) {
+            return static_cast<float>(std::log10(2.0 * dimension * D_fit * std::pow(step * delay, alpha)));
+        };
+        const float fit_y[] = {fitted(first_step), fitted(last_step)};
+        chart.set_curve(2, ends_x, fit_y, 2, sf::Color::Yellow);
+        chart.set_note(0, "alpha = " + std::to_string(alpha).substr(0, 6),
+                       sf::Vector2f(WINDOW_WIDTH - 220, 20), 16, sf::Color::Yellow);
+        chart.set_note(1, "D fit = " + std::to_string(D_fit).substr(0, 7),
+                       sf::Vector2f(WINDOW_WIDTH - 220, 45), 16, sf::Color::Yellow);
+    } else {
+        chart.set_curve(2, nullptr, nullptr, 0, sf::Color::Yellow);
+        chart.set_note(0, "", sf::Vector2f(), 16, sf::Color::Yellow);
+        chart.set_note(1, "", sf::Vector2f(), 16, sf::Color::Yellow);
     }
 }
 
-// === Функция отрисовки графика CDF ===
-void draw_histogram_with_rayleigh(sf::RenderWindow& window, sf::Font& font,
-                                  const std::vector<Particle>& particles,
-                                  int particle_count,
-                                  float mean_free_path,
-                                  int current_step) {
-    const float chart_left   = 80.f;
-    const float chart_top    = 80.f;
-    const float chart_width  = WINDOW_WIDTH - 160.f;
-    const float chart_height = WINDOW_HEIGHT - 160.f;
-
-    // Оси
-    sf::Vertex axis_x[] = {
-        sf::Vertex(sf::Vector2f(chart_left, chart_top + chart_height), sf::Color::White),
-        sf::Vertex(sf::Vector2f(chart_left + chart_width, chart_top + chart_height), sf::Color::White)
+// === График первого достижения радиусов ===
+// По ряду на радиус и поглощающую стенку: яркая кривая — доля частиц, дошедших
+// к концу столбца гистограммы, тусклая того же цвета — теория непрерывной
+// диффузии. xs, ys, theory — рабочие массивы. Вызывать под мьютексом истории.
+void update_passage_chart(Chart& chart, const PassageMonitor& passage,
+                          std::vector<float>& xs, std::vector<float>& ys, std::vector<float>& theory) {
+    static const sf::Color SERIES_COLORS[] = {
+        sf::Color::Cyan, sf::Color::Yellow, sf::Color::Magenta, sf::Color::Green, sf::Color(255, 140, 0)
     };
-    sf::Vertex axis_y[] = {
-        sf::Vertex(sf::Vector2f(chart_left, chart_top + chart_height), sf::Color::White),
-        sf::Vertex(sf::Vector2f(chart_left, chart_top), sf::Color::White)
-    };
-    window.draw(axis_x, 2, sf::Lines);
-    window.draw(axis_y, 2, sf::Lines);
+    const int bins = passage.bins_used();
+    if (!passage.enabled() || bins == 0) {
+        for (int i = 0; i < 2 * MAX_PASSAGE_TARGETS; ++i)
+            chart.set_curve(i, nullptr, nullptr, 0, sf::Color::White);
+        for (int i = 0; i < MAX_PASSAGE_TARGETS; ++i)
+            chart.set_note(i, "", sf::Vector2f(), 14, sf::Color::White);
+        chart.set_note(0, passage.enabled() ? "" : "Run with --passage R[,R...]",
+                       sf::Vector2f(WINDOW_WIDTH - 300, 20), 16, sf::Color::White);
+        return;
+    }
 
-    // Заголовок
-    sf::Text title("CDF vs Radius", font, 20);
-    title.setFillColor(sf::Color(160, 120, 140));
-    title.setPosition(10, 10);
-    window.draw(title);
+    const int last_step = bins * passage.bin_steps();
+    ChartAxis x_axis = {0.0f, Chart::nice_ceiling(static_cast<float>(last_step)), 10, format_integer};
+    ChartAxis y_axis = {0.0f, 1.0f, 10, format_fraction};
+    chart.set_axes(x_axis, y_axis);
+
+    xs.resize(bins + 1);
+    ys.resize(bins + 1);
+    theory.resize(bins + 1);
+    for (int k = 0; k < MAX_PASSAGE_TARGETS; ++k) {
+        if (k >= passage.target_count()) {
+            chart.set_curve(2 * k, nullptr, nullptr, 0, sf::Color::White);
+            chart.set_curve(2 * k + 1, nullptr, nullptr, 0, sf::Color::White);
+            chart.set_note(k, "", sf::Vector2f(), 14, sf::Color::White);
+            continue;
+        }
 
-    if (particles.empty()) return;
+        xs[0] = 0.0f;
+        ys[0] = 0.0f;
+        theory[0] = 0.0f;
+        for (int bin = 0; bin < bins; ++bin) {
+            const int end_step = (bin + 1) * passage.bin_steps();
+            xs[bin + 1] = static_cast<float>(end_step);
+            ys[bin + 1] = static_cast<float>(passage.empirical_cdf(k, bin));
+            theory[bin + 1] = static_cast<float>(passage.theory_cdf(k, end_step));
+        }
+
+        const sf::Color color = SERIES_COLORS[k % 5];
+        const sf::Color dim(color.r / 2, color.g / 2, color.b / 2);
+        chart.set_curve(2 * k, xs.data(), ys.data(), bins + 1, color);
+        chart.set_curve(2 * k + 1, xs.data(), theory.data(), bins + 1, dim);
 
-    // Собираем расстояния всех частиц от центра
-    std::vector<float> distances;
-    for (const auto& p : particles) {
-        float dist_sq = p.position.x * p.position.x + p.position.y * p.position.y;
-        distances.push_back(sqrt(dist_sq));
+        char line[96];
+        snprintf(line, sizeof(line), "%s: mean %.1f (theory %.1f), KS %.3f", passage.target_name(k).c_str(),
+                 passage.mean_time(k), passage.theory_mean(k), passage.ks_distance(k));
+        chart.set_note(k, line, sf::Vector2f(WINDOW_WIDTH - 360, 100 + 20.f * k), 14, color);
     }
-    std::sort(distances.begin(), distances.end());
+}
 
-    const int BIN_COUNT = 100;
-    std::vector<float> histogram_radii(BIN_COUNT);
-    std::vector<int> hit_counts(BIN_COUNT, 0);
+// === Камера, режимы отображения и отрисовка кадра ===
+// Общая часть живой симуляции и воспроизведения записи: источники кадров
+// разные, а сетка, частицы, карты плотности и графики CDF/PDF одни и те же.
+// V переключает вид сверху и изометрию; карты плотности и траектории
+// строятся по (x, y) и остаются видом сверху.
+class SimulationView {
+public:
+    // max_steps задаёт размер области карты посещений; pool — потоки для карт
+    // плотности, при живой симуляции это пул её движка
+    SimulationView(sf::RenderWindow& window, sf::Font& font, const Settings& settings,
+                   const OutputOptions& output, int max_steps, WorkerPool& pool, const char* usage);
 
-    float max_radius = distances.empty() ? 0.1f : distances.back();
+    // Клавиши вида и движение камеры; пробел, R и прочее управление ходом — у источника кадров
+    void handle_key(sf::Keyboard::Key key);
 
-    for (int i = 0; i < BIN_COUNT; ++i) {
-        histogram_radii[i] = max_radius * i / (BIN_COUNT - 1);
-    }
+    void clear_visits();
 
-    size_t count = 0;
-    for (int i = 0; i < BIN_COUNT && count < distances.size(); ++i) {
-        while (count < distances.size() && distances[count] <= histogram_radii[i]) {
-            ++count;
-        }
-        hit_counts[i] = static_cast<int>(count);
-    }
+    // Рисует снимок с его моментами; paths == nullptr, если у источника нет траекторий.
+    // msd и passage читаются под history_mutex, если тот задан; passage == nullptr — монитора нет.
+    void draw(const ParticleEnsemble& particles, const EnsembleMoments& moments,
+              const TrajectoryStore* paths, std::mutex* paths_mutex,
+              const MsdSeries& msd, const PassageMonitor* passage, std::mutex* history_mutex);
 
-    // Теоретическая CDF Рэлея
-    float sigma_sq = mean_free_path * mean_free_path * current_step;
-    if (sigma_sq <= 1e-5f) sigma_sq = 1e-5f;
+    // Показывает кадр и закрывает замер
+    void present();
 
-    std::vector<float> cdf_values(BIN_COUNT);
-    for (int i = 0; i < BIN_COUNT; ++i) {
-        float r = histogram_radii[i];
-        cdf_values[i] = 1.0f - exp(-r * r / (2 * sigma_sq));
-    }
+    bool dark_theme() const { return is_dark_theme; }
 
-    // === Рисуем бирюзовую линию (CDF) как накопленную долю частиц ===
-    for (int i = 1; i < BIN_COUNT; ++i) {
-        float x1 = chart_left + chart_width * histogram_radii[i - 1] / max_radius;
-        float x2 = chart_left + chart_width * histogram_radii[i] / max_radius;
-        float y1 = chart_top + chart_height - chart_height * (static_cast<float>(hit_counts[i - 1]) / particle_count);
-        float y2 = chart_top + chart_height - chart_height * (static_cast<float>(hit_counts[i]) / particle_count);
-        sf::Vertex line[] = {
-            sf::Vertex(sf::Vector2f(x1, y1), sf::Color::Cyan),
-            sf::Vertex(sf::Vector2f(x2, y2), sf::Color::Cyan)
-        };
-        window.draw(line, 2, sf::Lines);
-    }
+    FrameProfiler profiler;
 
-    // === Рисуем фиолетовую кривую (теоретическая CDF Рэлея) ===
-    for (int i = 1; i < BIN_COUNT; ++i) {
-        float x1 = chart_left + chart_width * histogram_radii[i - 1] / max_radius;
-        float x2 = chart_left + chart_width * histogram_radii[i] / max_radius;
-        float y1 = chart_top + chart_height - chart_height * cdf_values[i - 1];
-        float y2 = chart_top + chart_height - chart_height * cdf_values[i];
-        sf::Vertex line[] = {
-            sf::Vertex(sf::Vector2f(x1, y1), sf::Color::Magenta),
-            sf::Vertex(sf::Vector2f(x2, y2), sf::Color::Magenta)
-        };
-        window.draw(line, 2, sf::Lines);
-    }
+private:
+    void draw_grid();
+    void draw_isometric_grid();
+    void draw_domain();
 
-    // === Рисуем зелёную линию для теоретического RMS радиуса ===
-    float theoretical_R = mean_free_path * sqrt(2 * current_step);
-    float theoretical_N = 1.0f - exp(-theoretical_R * theoretical_R / (2 * sigma_sq));
-    float x_start_theory = chart_left;
-    float x_end_theory = chart_left + chart_width * theoretical_R / max_radius;
-    float y_N_theory = chart_top + chart_height - chart_height * theoretical_N;
-    sf::Vertex hline_theory[] = {
-        sf::Vertex(sf::Vector2f(x_start_theory, y_N_theory), sf::Color::Green),
-        sf::Vertex(sf::Vector2f(x_end_theory, y_N_theory), sf::Color::Green)
-    };
-    window.draw(hline_theory, 2, sf::Lines);
+    sf::RenderWindow& window;
+    sf::Font& font;
+    Settings settings;
+    Domain domain;
 
-    float arrow_length = 10.0f;
+    sf::View camera;
+    float current_zoom = 1.0f;
+    EnsembleStats stats;
+    ParticleRenderer renderer;
+    DensityHeatmap heatmap;
+    int visits_step = -1;
+
+    Chart cdf_chart;
+    Chart pdf_chart;
+    Chart msd_chart;
+    Chart passage_chart;
+    std::vector<float> msd_x, msd_y;
+    std::vector<float> passage_theory;
+    PassageMonitor no_passage;
+    int plotted_step = -1;
+    int plotted_mode = -1;
 
-    // Стрелочка слева
-    sf::Vertex left_arrow[] = {
-        sf::Vertex(sf::Vector2f(x_start_theory, y_N_theory), sf::Color::Green),
-        sf::Vertex(sf::Vector2f(x_start_theory + arrow_length, y_N_theory - arrow_length), sf::Color::Green),
-        sf::Vertex(sf::Vertex(sf::Vector2f(x_start_theory, y_N_theory), sf::Color::Green)),
-        sf::Vertex(sf::Vector2f(x_start_theory + arrow_length, y_N_theory + arrow_length), sf::Color::Green)
-    };
-    window.draw(left_arrow, 4, sf::Lines);
-
-    // Стрелочка справа
-    sf::Vertex right_arrow[] = {
-        sf::Vertex(sf::Vector2f(x_end_theory, y_N_theory), sf::Color::Green),
-        sf::Vertex(sf::Vector2f(x_end_theory - arrow_length, y_N_theory - arrow_length), sf::Color::Green),
-        sf::Vertex(sf::Vertex(sf::Vector2f(x_end_theory, y_N_theory), sf::Color::Green)),
-        sf::Vertex(sf::Vector2f(x_end_theory - arrow_length, y_N_theory + arrow_length), sf::Color::Green)
-    };
-    window.draw(right_arrow, 4, sf::Lines);
-
-    // Надпись R, N(R)
-    sf::Text label_r_theory("R = " + std::to_string(theoretical_R).substr(0, 5), font, 14);
-    label_r_theory.setFillColor(sf::Color::Green);
-    label_r_theory.setPosition(WINDOW_WIDTH - 150, 120);
-    window.draw(label_r_theory);
-
-    sf::Text label_n_theory("N(R) = " + std::to_string(theoretical_N).substr(0, 5), font, 14);
-    label_n_theory.setFillColor(sf::Color::Green);
-    label_n_theory.setPosition(WINDOW_WIDTH - 150, 140);
-    window.draw(label_n_theory);
-
-    // === Теперь рисуем аналогичную линию для экспериментального RMS радиуса R' ===
-    float sum_r_squared = 0.0f;
-    for (const auto& p : particles) {
-        float r = sqrt(p.position.x * p.position.x + p.position.y * p.position.y);
-        sum_r_squared += r * r;
-    }
-    float R_prime = sqrt(sum_r_squared / particle_count); // Среднее квадратичное отклонение
-    float N_of_R_prime = 0.0f;
+    bool show_controls = true;
+    bool is_dark_theme = true;
+    bool show_paths = true;
+    bool show_plot_mode = false;
+    bool show_profiler = false;
+    int info_mode = 0; // 0: CDF, 1: PDF, 2: MSD(t), 3: первое достижение
+    int render_mode = 0; // 0: частицы, 1: плотность, 2: посещения
+    Projection projection = PROJECTION_TOP;
+
+    sf::Text controls;
+};
+
+SimulationView::SimulationView(sf::RenderWindow& window, sf::Font& font, const Settings& settings,
+                               const OutputOptions& output, int max_steps, WorkerPool& pool, const char* usage)
+    : window(window),
+      font(font),
+      settings(settings),
+      domain(domain_from_settings(settings)),
+      camera(window.getDefaultView()),
+      // Карта посещений покрывает область с запасом в 3 теоретических радиуса к последнему шагу
+      heatmap(pool, 3 * settings.mean_free_path * std::sqrt(2.0f * std::max(max_steps, 1))),
+      cdf_chart(font, chart_area(), "CDF vs Radius", "Radius", "CDF", 2),
+      pdf_chart(font, chart_area(), "PDF vs Radius", "Radius", "PDF", 2),
+      msd_chart(font, chart_area(), "MSD vs Steps (log-log)", "Steps", "<r^2>", 3),
+      passage_chart(font, chart_area(), "First passage CDF", "Steps", "Fraction", 2 * MAX_PASSAGE_TARGETS),
+      controls(usage, font, 16) {
+    camera.setCenter(0, 0);
+    window.setView(camera);
 
-    // Находим N(R') по экспериментальной CDF
-    for (size_t i = 0; i < histogram_radii.size(); ++i) {
-        if (histogram_radii[i] >= R_prime) {
-            N_of_R_prime = static_cast<float>(hit_counts[i]) / particle_count;
-            break;
-        }
+    // Замеры фаз кадра; при заданном profile_path каждый кадр пишется в файл новой сессией
+    profiler.attach_dump(output.profile_dump);
+
+    controls.setFillColor(sf::Color::White);
+    controls.setPosition(10, 10);
+}
+
+void SimulationView::handle_key(sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::H)
+        show_controls = !show_controls;
+    if (key == sf::Keyboard::T) {
+        is_dark_theme = !is_dark_theme;
+        controls.setFillColor(is_dark_theme ? sf::Color::White : sf::Color::Black);
+        window.clear(is_dark_theme ? sf::Color(30, 30, 30) : sf::Color(245, 245, 245));
     }
-    if (N_of_R_prime == 0.0f && !hit_counts.empty()) {
-        N_of_R_prime = static_cast<float>(hit_counts.back()) / particle_count;
+    if (key == sf::Keyboard::M)
+        render_mode = (render_mode + 1) % 3;
+    if (key == sf::Keyboard::O)
+        show_profiler = !show_profiler;
+    if (key == sf::Keyboard::P)
+        show_paths = !show_paths;
+    if (key == sf::Keyboard::V)
+        projection = projection == PROJECTION_TOP ? PROJECTION_ISOMETRIC : PROJECTION_TOP;
+    if (key == sf::Keyboard::Tab)
+        info_mode = (info_mode + 1) % 4; // CDF -> PDF -> MSD(t) -> первое достижение
+    if (key == sf::Keyboard::LShift || key == sf::Keyboard::RShift)
+        show_plot_mode = !show_plot_mode;
+
+    // Камера и зум
+    int left    = sf::Keyboard::isKeyPressed(sf::Keyboard::Left );
+    int right   = sf::Keyboard::isKeyPressed(sf::Keyboard::Right);
+    int up      = sf::Keyboard::isKeyPressed(sf::Keyboard::Up   );
+    int down    = sf::Keyboard::isKeyPressed(sf::Keyboard::Down );
+    bool zoom   = sf::Keyboard::isKeyPressed(sf::Keyboard::Z );
+    bool reduce = sf::Keyboard::isKeyPressed(sf::Keyboard::X );
+
+    float offset_x = current_zoom * MOVE_CAMERA_FACTOR * (right - left);
+    float offset_y = current_zoom * MOVE_CAMERA_FACTOR * (down - up);
+    camera.move(offset_x, offset_y);
+
+    if (zoom) {
+        current_zoom *= ZOOM_IN_CAMERA_FACTOR;
+        camera.zoom(ZOOM_IN_CAMERA_FACTOR);
     }
+    if (reduce) {
+        current_zoom *= ZOOM_OUT_CAMERA_FACTOR;
+        camera.zoom(ZOOM_OUT_CAMERA_FACTOR);
+    }
+}
+
+void SimulationView::clear_visits() {
+    heatmap.clear_visits();
+    visits_step = -1;
+}
 
-    // Позиции на графике
-    float x_start_exp = chart_left;
-    float x_end_exp = chart_left + chart_width * R_prime / max_radius;
-    float y_N_exp = chart_top + chart_height - chart_height * N_of_R_prime;
+// === Сетка и оси в плоскости экрана (вид сверху) ===
+void SimulationView::draw_grid() {
+    float min_x = camera.getCenter().x - camera.getSize().x / 2.f;
+    float max_x = camera.getCenter().x + camera.getSize().x / 2.f;
+    float min_y = camera.getCenter().y - camera.getSize().y / 2.f;
+    float max_y = camera.getCenter().y + camera.getSize().y / 2.f;
 
-    // Горизонтальная линия
-    sf::Vertex hline_exp[] = {
-        sf::Vertex(sf::Vector2f(x_start_exp, y_N_exp), sf::Color::Yellow),
-        sf::Vertex(sf::Vector2f(x_end_exp, y_N_exp), sf::Color::Yellow)
-    };
-    window.draw(hline_exp, 2, sf::Lines);
-
-    // Стрелочки
-    sf::Vertex left_arrow_exp[] = {
-        sf::Vertex(sf::Vector2f(x_start_exp, y_N_exp), sf::Color::Yellow),
-        sf::Vertex(sf::Vector2f(x_start_exp + arrow_length, y_N_exp - arrow_length), sf::Color::Yellow),
-        sf::Vertex(sf::Vertex(sf::Vector2f(x_start_exp, y_N_exp), sf::Color::Yellow)),
-        sf::Vertex(sf::Vector2f(x_start_exp + arrow_length, y_N_exp + arrow_length), sf::Color::Yellow)
-    };
-    window.draw(left_arrow_exp, 4, sf::Lines);
+    sf::Color grid_color = is_dark_theme ? sf::Color(80, 80, 80) : sf::Color(180, 180, 180);
+    sf::Color axis_color = is_dark_theme ? sf::Color::White : sf::Color::Black;
 
-    sf::Vertex right_arrow_exp[] = {
-        sf::Vertex(sf::Vector2f(x_end_exp, y_N_exp), sf::Color::Yellow),
-        sf::Vertex(sf::Vector2f(x_end_exp - arrow_length, y_N_exp - arrow_length), sf::Color::Yellow),
-        sf::Vertex(sf::Vertex(sf::Vector2f(x_end_exp, y_N_exp), sf::Color::Yellow)),
-        sf::Vertex(sf::Vector2f(x_end_exp - arrow_length, y_N_exp + arrow_length), sf::Color::Yellow)
-    };
-    window.draw(right_arrow_exp, 4, sf::Lines);
-
-    // Надпись R', N(R')
-    sf::Text label_r_exp("R' = " + std::to_string(R_prime).substr(0, 5), font, 14);
-    label_r_exp.setFillColor(sf::Color::Yellow);
-    label_r_exp.setPosition(WINDOW_WIDTH - 150, 180);
-    window.draw(label_r_exp);
-
-    sf::Text label_n_exp("N(R') = " + std::to_string(N_of_R_prime).substr(0, 5), font, 14);
-    label_n_exp.setFillColor(sf::Color::Yellow);
-    label_n_exp.setPosition(WINDOW_WIDTH - 150, 200);
-    window.draw(label_n_exp);
-
-    // === Подписываем деления по осям ===
-    const int TICKS_X = 10;
-    const int TICKS_Y = 10;
-
-    for (int i = 0; i <= TICKS_X; ++i) {
-        float r = max_radius * i / TICKS_X;
-        float x = chart_left + chart_width * i / TICKS_X;
-        sf::Vertex tick[] = {
-            sf::Vertex(sf::Vector2f(x, chart_top + chart_height), sf::Color::White),
-            sf::Vertex(sf::Vector2f(x, chart_top + chart_height + 5), sf::Color::White)
+    float grid_step = settings.mean_free_path * 10;
+    float start_x = std::floor(min_x / grid_step) * grid_step;
+    float end_x   = std::ceil(max_x / grid_step) * grid_step;
+    float start_y = std::floor(min_y / grid_step) * grid_step;
+    float end_y   = std::ceil(max_y / grid_step) * grid_step;
+
+    for (float x = start_x; x <= end_x; x += grid_step) {
+        sf::Vertex line[] = {
+            sf::Vertex(sf::Vector2f(x, min_y), grid_color),
+            sf::Vertex(sf::Vector2f(x, max_y), grid_color)
         };
-        window.draw(tick, 2, sf::Lines);
-        sf::Text label(std::to_string(int(r)), font, 14);
-        label.setFillColor(sf::Color::White);
-        label.setPosition(x - 10, chart_top + chart_height + 10);
-        window.draw(label);
+        window.draw(line, 2, sf::Lines);
     }
 
-    for (int i = 0; i <= TICKS_Y; ++i) {
-        float fraction = i / (float)TICKS_Y;
-        float y = chart_top + chart_height - chart_height * fraction;
-        sf::Vertex tick[] = {
-            sf::Vertex(sf::Vector2f(chart_left, y), sf::Color::White),
-            sf::Vertex(sf::Vector2f(chart_left - 5, y), sf::Color::White)
+    for (float y = start_y; y <= end_y; y += grid_step) {
+        sf::Vertex line[] = {
+            sf::Vertex(sf::Vector2f(min_x, y), grid_color),
+            sf::Vertex(sf::Vector2f(max_x, y), grid_color)
         };
-        window.draw(tick, 2, sf::Lines);
-        sf::Text label(std::to_string(fraction).substr(0, 3), font, 14);
-        label.setFillColor(sf::Color::White);
-        label.setPosition(chart_left - 40, y - 10);
-        window.draw(label);
+        window.draw(line, 2, sf::Lines);
     }
 
-    // === Подписи осей ===
-    sf::Text label_x("Radius", font, 16);
-    label_x.setFillColor(sf::Color::White);
-    label_x.setPosition(chart_left + chart_width / 2 - 30, chart_top + chart_height + 40);
-    window.draw(label_x);
-
-    sf::Text label_y("CDF", font, 16);
-    label_y.setFillColor(sf::Color::White);
-    label_y.setRotation(-90);
-    label_y.setPosition(chart_left - 50, chart_top + chart_height / 2 - 20);
-    window.draw(label_y);
-}
-
-// === Функция отрисовки графика PDF ===
-void draw_histogram_pdf(sf::RenderWindow& window, sf::Font& font,
-                        const std::vector<Particle>& particles,
-                        int particle_count,
-                        float mean_free_path,
-                        int current_step) {
-    const float chart_left   = 80.f;
-    const float chart_top    = 80.f;
-    const float chart_width  = WINDOW_WIDTH - 160.f;
-    const float chart_height = WINDOW_HEIGHT - 160.f;
-
-    // Оси
+    // Оси координат
     sf::Vertex axis_x[] = {
-        sf::Vertex(sf::Vector2f(chart_left, chart_top + chart_height), sf::Color::White),
-        sf::Vertex(sf::Vector2f(chart_left + chart_width, chart_top + chart_height), sf::Color::White)
+        sf::Vertex(sf::Vector2f(-1e6, 0), axis_color),
+        sf::Vertex(sf::Vector2f(1e6, 0), axis_color)
     };
     sf::Vertex axis_y[] = {
-        sf::Vertex(sf::Vector2f(chart_left, chart_top + chart_height), sf::Color::White),
-        sf::Vertex(sf::Vector2f(chart_left, chart_top), sf::Color::White)
+        sf::Vertex(sf::Vector2f(0, -1e6), axis_color),
+        sf::Vertex(sf::Vector2f(0, 1e6), axis_color)
     };
     window.draw(axis_x, 2, sf::Lines);
     window.draw(axis_y, 2, sf::Lines);
+}
 
-    // Заголовок
-    sf::Text title("PDF vs Radius", font, 20);
-    title.setFillColor(sf::Color(160, 120, 140));
-    title.setPosition(10, 10);
-    window.draw(title);
-
-    if (particles.empty()) return;
-
-    // Собираем расстояния всех частиц от центра
-    std::vector<float> distances;
-    for (const auto& p : particles) {
-        distances.push_back(std::sqrt(p.position.x * p.position.x + p.position.y * p.position.y));
+// === Сетка плоскости z = 0 и три оси в изометрии ===
+// Плоскость xy на экране — ромб, поэтому сетка строится в координатах
+// пространства по квадрату, который накрывает видимую часть экрана.
+void SimulationView::draw_isometric_grid() {
+    const float reach = (std::fabs(camera.getCenter().x) + camera.getSize().x / 2.f) / ISO_COS +
+                        (std::fabs(camera.getCenter().y) + camera.getSize().y / 2.f) / ISO_SIN;
+
+    sf::Color grid_color = is_dark_theme ? sf::Color(80, 80, 80) : sf::Color(180, 180, 180);
+    sf::Color axis_color = is_dark_theme ? sf::Color::White : sf::Color::Black;
+
+    float grid_step = settings.mean_free_path * 10;
+    float extent = std::ceil(reach / grid_step) * grid_step;
+
+    sf::VertexArray grid(sf::Lines);
+    for (float v = -extent; v <= extent; v += grid_step) {
+        grid.append(sf::Vertex(isometric(v, -extent, 0), grid_color));
+        grid.append(sf::Vertex(isometric(v, extent, 0), grid_color));
+        grid.append(sf::Vertex(isometric(-extent, v, 0), grid_color));
+        grid.append(sf::Vertex(isometric(extent, v, 0), grid_color));
     }
-    std::sort(distances.begin(), distances.end());
-
-    const int BIN_COUNT = 100;
-    std::vector<float> histogram_radii(BIN_COUNT);
-    std::vector<int> hit_counts(BIN_COUNT, 0);
 
-    float max_radius = distances.empty() ? 0.1f : distances.back();
-
-    for (int i = 0; i < BIN_COUNT; ++i) {
-        histogram_radii[i] = max_radius * i / (BIN_COUNT - 1);
-    }
+    // Оси координат: x и y по сторонам ромба, z — вертикаль экрана
+    const float axis = 1e6f;
+    grid.append(sf::Vertex(isometric(-axis, 0, 0), axis_color));
+    grid.append(sf::Vertex(isometric(axis, 0, 0), axis_color));
+    grid.append(sf::Vertex(isometric(0, -axis, 0), axis_color));
+    grid.append(sf::Vertex(isometric(0, axis, 0), axis_color));
+    grid.append(sf::Vertex(isometric(0, 0, -axis), axis_color));
+    grid.append(sf::Vertex(isometric(0, 0, axis), axis_color));
+    window.draw(grid);
+}
 
-    size_t count = 0;
-    for (int i = 0; i < BIN_COUNT && count < distances.size(); ++i) {
-        while (count < distances.size() && distances[count] <= histogram_radii[i]) {
-            ++count;
+// === Граница области в плоскости z = 0: контур ящика или окружность ===
+void SimulationView::draw_domain() {
+    if (domain.kind == BOUNDARY_NONE)
+        return;
+
+    const int SEGMENTS = 128;
+    const float PI = 3.14159265f;
+    const float half = 0.5f * domain.size;
+    const sf::Color color = domain.kind == BOUNDARY_ABSORBING ? sf::Color(220, 80, 80) : sf::Color(80, 160, 220);
+
+    sf::VertexArray outline(sf::LineStrip);
+    for (int k = 0; k <= SEGMENTS; ++k) {
+        float x, y;
+        if (domain.kind == BOUNDARY_CIRCULAR) {
+            x = domain.size * std::cos(2.0f * PI * k / SEGMENTS);
+            y = domain.size * std::sin(2.0f * PI * k / SEGMENTS);
+        } else {
+            // Углы квадрата по кругу, по четверти контура на сторону
+            static const float CORNERS[][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}, {-1, -1}};
+            const int side = std::min(k * 4 / SEGMENTS, 3);
+            const float t = k * 4.0f / SEGMENTS - side;
+            x = half * (CORNERS[side][0] + t * (CORNERS[side + 1][0] - CORNERS[side][0]));
+            y = half * (CORNERS[side][1] + t * (CORNERS[side + 1][1] - CORNERS[side][1]));
         }
-        hit_counts[i] = static_cast<int>(count);
+        outline.append(sf::Vertex(projection == PROJECTION_ISOMETRIC ? isometric(x, y, 0) : sf::Vector2f(x, y),
+                                  color));
     }
+    window.draw(outline);
+}
 
-    // Подсчёт плотности
-    float sigma_sq = mean_free_path * mean_free_path * current_step;
-    if (sigma_sq <= 1e-5f) sigma_sq = 1e-5f;
+void SimulationView::draw(const ParticleEnsemble& particles, const EnsembleMoments& moments,
+                          const TrajectoryStore* paths, std::mutex* paths_mutex,
+                          const MsdSeries& msd, const PassageMonitor* passage, std::mutex* history_mutex) {
+    const int current_step = moments.step;
+    // Статистика только помечается устаревшей; считают её те виды,
+    // которые сейчас на экране, и не чаще раза за снимок
+    stats.bind(particles, moments, settings.mean_free_path, settings.delay);
+
+    // Посещения копятся по одному разу на новый снимок и только пока карта на экране
+    if (render_mode == 2 && !show_plot_mode && current_step != visits_step) {
+        ScopedTimer heatmap_timer(profiler, PROFILE_HEATMAP);
+        if (current_step < visits_step)
+            heatmap.clear_visits();
+        heatmap.accumulate_visits(particles);
+        visits_step = current_step;
+    }
 
-    float dr = max_radius / (BIN_COUNT - 1);
-    std::vector<float> empirical_pdf(BIN_COUNT);
-    std::vector<float> pdf_values(BIN_COUNT);
+    window.clear(is_dark_theme ? sf::Color(30, 30, 30) : sf::Color(245, 245, 245));
 
-    for (int i = 0; i < BIN_COUNT; ++i) {
-        float r = histogram_radii[i];
-        pdf_values[i] = (r / sigma_sq) * exp(-r * r / (2 * sigma_sq));
-        empirical_pdf[i] = (hit_counts[i] - (i > 0 ? hit_counts[i - 1] : 0)) / (dr * particle_count);
-    }
+    if (!show_plot_mode) {
+        window.setView(camera);
+        {
+            ScopedTimer grid_timer(profiler, PROFILE_GRID);
+            if (projection == PROJECTION_ISOMETRIC)
+                draw_isometric_grid();
+            else
+                draw_grid();
+            draw_domain();
+        }
 
-    // === Найдём максимумы для масштабирования ===
-    float max_empirical = !empirical_pdf.empty() ? *std::max_element(empirical_pdf.begin(), empirical_pdf.end()) : 0.1f;
-    float max_theoretical = !pdf_values.empty() ? *std::max_element(pdf_values.begin(), pdf_values.end()) : 0.1f;
-    float y_max = std::max(max_empirical, max_theoretical);
-    if (y_max < 1e-5f) y_max = 1e-5f;
+        if (render_mode == 1) {
+            ScopedTimer heatmap_timer(profiler, PROFILE_HEATMAP);
+            heatmap.draw_density(window, particles, camera);
+        } else if (render_mode == 2) {
+            ScopedTimer heatmap_timer(profiler, PROFILE_HEATMAP);
+            heatmap.draw_visits(window);
+        } else {
+            // Траектории хранятся только в плоскости xy и в изометрии не рисуются
+            if (show_paths && paths && projection == PROJECTION_TOP) {
+                ScopedTimer paths_timer(profiler, PROFILE_PATHS);
+                std::lock_guard<std::mutex> lock(*paths_mutex);
+                renderer.draw_paths(window, *paths);
+            }
 
-    // === Рисуем бирюзовую линию (экспериментальная PDF) ===
-    for (int i = 1; i < BIN_COUNT; ++i) {
-        float x1 = chart_left + chart_width * histogram_radii[i - 1] / max_radius;
-        float x2 = chart_left + chart_width * histogram_radii[i] / max_radius;
-        float y1 = chart_top + chart_height - chart_height * (empirical_pdf[i - 1] / y_max);
-        float y2 = chart_top + chart_height - chart_height * (empirical_pdf[i] / y_max);
-        sf::Vertex line[] = {
-            sf::Vertex(sf::Vector2f(x1, y1), sf::Color::Cyan),
-            sf::Vertex(sf::Vector2f(x2, y2), sf::Color::Cyan)
-        };
-        window.draw(line, 2, sf::Lines);
-    }
+            ScopedTimer particles_timer(profiler, PROFILE_PARTICLES);
+            renderer.draw_particles(window, particles, current_zoom, sf::Color::Red, projection);
+        }
 
-    // === Рисуем фиолетовую кривую (теоретическая PDF Рэлея) ===
-    for (int i = 1; i < BIN_COUNT; ++i) {
-        float x1 = chart_left + chart_width * histogram_radii[i - 1] / max_radius;
-        float x2 = chart_left + chart_width * histogram_radii[i] / max_radius;
-        float y1 = chart_top + chart_height - chart_height * (pdf_values[i - 1] / y_max);
-        float y2 = chart_top + chart_height - chart_height * (pdf_values[i] / y_max);
-        sf::Vertex line[] = {
-            sf::Vertex(sf::Vector2f(x1, y1), sf::Color::Magenta),
-            sf::Vertex(sf::Vector2f(x2, y2), sf::Color::Magenta)
-        };
-        window.draw(line, 2, sf::Lines);
-    }
+        // === Эмпирический расчёт коэффициента диффузии D ===
+        float D_empirical;
+        {
+            ScopedTimer stats_timer(profiler, PROFILE_STATS);
+            D_empirical = stats.diffusion_coefficient();
+        }
 
-    // === Теоретический пик (RMS) ===
-    float theoretical_R = mean_free_path * sqrt(current_step); // RMS радиус
-    float sigma = theoretical_R;
-    sigma_sq = sigma * sigma;
+        ScopedTimer hud_timer(profiler, PROFILE_HUD);
+
+        float radius = 2 * settings.mean_free_path * sqrt(current_step);
+        if (radius > 0) {
+            sf::CircleShape dynamic_circle(radius);
+            dynamic_circle.setOrigin(radius, radius);
+            dynamic_circle.setPosition(0.f, 0.f);
+            // Окружность в плоскости z = 0 в изометрии становится эллипсом
+            if (projection == PROJECTION_ISOMETRIC)
+                dynamic_circle.setScale(ISO_COS * std::sqrt(2.f), ISO_SIN * std::sqrt(2.f));
+            dynamic_circle.setOutlineThickness(pow(current_step, 0.25f) * current_zoom);
+            dynamic_circle.setOutlineColor(sf::Color(128, 128, 128));
+            dynamic_circle.setFillColor(sf::Color::Transparent);
+            window.draw(dynamic_circle);
+        }
 
-    // Поиск пика в теоретическом графике PDF
-    auto max_it = std::max_element(pdf_values.begin(), pdf_values.end());
-    int peak_index = static_cast<int>(std::distance(pdf_values.begin(), max_it));
-    float r_peak_theory = histogram_radii[peak_index];
+        window.setView(window.getDefaultView());
+        if (show_controls) {
+            controls.setFillColor(is_dark_theme ? sf::Color::White : sf::Color::Black);
+            window.draw(controls);
+        }
 
-    // === Поиск пика в экспериментальном графике PDF ===
-    auto max_it_exp = std::max_element(empirical_pdf.begin(), empirical_pdf.end());
-    int peak_index_exp = static_cast<int>(std::distance(empirical_pdf.begin(), max_it_exp));
-    float r_peak_experiment = histogram_radii[peak_index_exp];
-
-    // === Выводим значения пиков справа сверху ===
-    sf::Text label_theory("Theory Peak: " + std::to_string(r_peak_theory).substr(0, 5), font, 16);
-    label_theory.setFillColor(sf::Color::Green);
-    label_theory.setPosition(WINDOW_WIDTH - 220, 20);
-    window.draw(label_theory);
-
-    sf::Text label_exp("Experimental Peak: " + std::to_string(r_peak_experiment).substr(0, 5), font, 16);
-    label_exp.setFillColor(sf::Color::Yellow);
-    label_exp.setPosition(WINDOW_WIDTH - 220, 50);
-    window.draw(label_exp);
-
-    // === Подписываем деления по осям ===
-    const int TICKS_X = 10;
-    const int TICKS_Y = 10;
-
-    for (int i = 0; i <= TICKS_X; ++i) {
-        float r = max_radius * i / TICKS_X;
-        float x = chart_left + chart_width * i / TICKS_X;
-        sf::Vertex tick[] = {
-            sf::Vertex(sf::Vector2f(x, chart_top + chart_height), sf::Color::White),
-            sf::Vertex(sf::Vector2f(x, chart_top + chart_height + 5), sf::Color::White)
-        };
-        window.draw(tick, 2, sf::Lines);
-        sf::Text label(std::to_string(int(r)), font, 14);
-        label.setFillColor(sf::Color::White);
-        label.setPosition(x - 10, chart_top + chart_height + 10);
-        window.draw(label);
+        // Вывод значения D на экран
+        sf::Text label_D("D = " + std::to_string(D_empirical).substr(0, 6) + " nm/sec^2", font, 22);
+        label_D.setFillColor(sf::Color::Green);
+        label_D.setPosition(WINDOW_WIDTH - 275, 30);
+        window.draw(label_D);
+
+        // Негауссов параметр и дисперсии по осям — из тех же моментов, что и D
+        char moments_line[96];
+        if (moments.dimension == 3)
+            snprintf(moments_line, sizeof(moments_line), "alpha2 = %+.4f   var x/y/z = %.0f / %.0f / %.0f",
+                     moments.non_gaussian(), moments.var_x, moments.var_y, moments.var_z);
+        else
+            snprintf(moments_line, sizeof(moments_line), "alpha2 = %+.4f   var x/y = %.0f / %.0f",
+                     moments.non_gaussian(), moments.var_x, moments.var_y);
+        sf::Text label_moments(moments_line, font, 14);
+        label_moments.setFillColor(sf::Color::Green);
+        label_moments.setPosition(WINDOW_WIDTH - 275, 60);
+        window.draw(label_moments);
+
+        // Поглощающие стенки: сколько частиц ещё в области
+        if (domain.kind == BOUNDARY_ABSORBING) {
+            sf::Text label_alive("alive = " + std::to_string(particles.count) + " / " +
+                                 std::to_string(settings.particle_count), font, 14);
+            label_alive.setFillColor(sf::Color::Green);
+            label_alive.setPosition(WINDOW_WIDTH - 275, 80);
+            window.draw(label_alive);
+        }
+    } else {
+        // Кривые считаются отдельно от отрисовки, чтобы их время было видно
+        {
+            ScopedTimer stats_timer(profiler, PROFILE_STATS);
+            if (info_mode == 0)
+                stats.cdf();
+            else if (info_mode == 1)
+                stats.pdf();
+            if (info_mode < 2)
+                stats.goodness();
+        }
+        // Вершины и надписи графика обновляются раз на снимок, в остальные кадры рисуются готовые
+        ScopedTimer plot_timer(profiler, PROFILE_PLOT);
+        Chart& chart = info_mode == 0 ? cdf_chart : info_mode == 1 ? pdf_chart :
+                       info_mode == 2 ? msd_chart : passage_chart;
+        if (current_step != plotted_step || info_mode != plotted_mode) {
+            if (info_mode == 0) {
+                update_cdf_chart(chart, stats);
+            } else if (info_mode == 1) {
+                update_pdf_chart(chart, stats);
+            } else if (info_mode == 3) {
+                std::unique_lock<std::mutex> lock;
+                if (history_mutex)
+                    lock = std::unique_lock<std::mutex>(*history_mutex);
+                update_passage_chart(chart, passage ? *passage : no_passage, msd_x, msd_y, passage_theory);
+            } else if (history_mutex) {
+                std::lock_guard<std::mutex> lock(*history_mutex);
+                update_msd_chart(chart, msd, settings.mean_free_path, settings.delay, settings.dimension,
+                                 msd_x, msd_y);
+            } else {
+                update_msd_chart(chart, msd, settings.mean_free_path, settings.delay, settings.dimension,
+                                 msd_x, msd_y);
+            }
+            plotted_step = current_step;
+            plotted_mode = info_mode;
+        }
+        chart.draw(window);
     }
 
-    for (int i = 0; i <= TICKS_Y; ++i) {
-        float fraction = i / (float)TICKS_Y;
-        float y = chart_top + chart_height - chart_height * fraction;
-        sf::Vertex tick[] = {
-            sf::Vertex(sf::Vector2f(chart_left, y), sf::Color::White),
-            sf::Vertex(sf::Vector2f(chart_left - 5, y), sf::Color::White)
-        };
-        window.draw(tick, 2, sf::Lines);
-        float value = y_max * fraction;
-        sf::Text label((value > 0.00001f ? std::to_string(value).substr(0, 7) : "0"), font, 14);
-        label.setFillColor(sf::Color::White);
-        label.setPosition(chart_left - 70, y - 10);
-        window.draw(label);
+    if (show_profiler) {
+        ScopedTimer hud_timer(profiler, PROFILE_HUD);
+        window.setView(window.getDefaultView());
+        profiler.draw_overlay(window, font, sf::Vector2f(10.f, WINDOW_HEIGHT - 260.f),
+                              is_dark_theme ? sf::Color::White : sf::Color::Black);
     }
-
-    // === Подписи осей ===
-    sf::Text label_x("Radius", font, 16);
-    label_x.setFillColor(sf::Color::White);
-    label_x.setPosition(chart_left + chart_width / 2 - 30, chart_top + chart_height + 40);
-    window.draw(label_x);
-
-    sf::Text label_y("PDF", font, 16);
-    label_y.setFillColor(sf::Color::White);
-    label_y.setRotation(-90);
-    label_y.setPosition(chart_left - 50, chart_top + chart_height / 2 - 20);
-    window.draw(label_y);
 }
 
-// === Основной цикл симуляции с шагами распределенными экспоненциально ===
-void run_simulation(sf::RenderWindow& window, sf::Font& font, Settings settings) {
-    sf::View camera = window.getDefaultView();
-    camera.setCenter(0, 0);
-    window.setView(camera);
-
-    std::vector<Particle> particles(settings.particle_count);
-    sf::Color colors[] = {
-        sf::Color(255, 100, 100),
-        sf::Color(100, 255, 100),
-        sf::Color(100, 100, 255),
-        sf::Color(255, 100, 255),
-        sf::Color(100, 255, 255),
-        sf::Color(255, 255, 100)
-    };
-
-    for (int i = 0; i < settings.particle_count; ++i) {
-        Particle p;
-        p.position = sf::Vector2f(0, 0);
-        p.path.push_back(sf::Vertex(p.position, colors[i % 6]));
-        p.color = colors[i % 6];
-        particles[i] = p;
+void SimulationView::present() {
+    {
+        ScopedTimer display_timer(profiler, PROFILE_DISPLAY);
+        window.display();
     }
+    profiler.end_frame();
+}
 
-    bool paused = false;
-    int current_step = 0;
-    bool show_controls = true;
-    bool is_dark_theme = true;
-    bool show_paths = true;
-    bool show_plot_mode = false;
-    int info_mode = 0; // 0: CDF, 1: PDF
-
-    // Controls text
-    sf::Text controls(
+// === Основной цикл симуляции с шагами распределенными экспоненциально ===
+void run_simulation(sf::RenderWindow& window, sf::Font& font, Settings settings, const OutputOptions& output) {
+    // Шаги считает отдельный поток, окно только рисует последний снимок.
+    // Поток создаётся первым: его пул делят шаг и карты плотности окна.
+    SimulationRunner runner(settings, output);
+    SimulationView view(window, font, settings, output, MAX_STEPS, runner.worker_pool(),
         "Usage:\n"
         "Q - Back to Menu\n"
         "T - Toggle Theme\n"
@@ -505,192 +685,234 @@ void run_simulation(sf::RenderWindow& window, sf::Font& font, Settings settings)
         "Space - Pause\n"
         "R - Reset\n"
         "Z/X - Zoom\n"
-        "Tab - Switch plot PDF/CDF\n"
-        "Shift - Show plot",
-        font, 16
-    );
-    controls.setFillColor(sf::Color::White);
-    controls.setPosition(10, 10);
+        "Tab - Switch plot CDF/PDF/MSD/passage\n"
+        "Shift - Show plot\n"
+        "F - Toggle max speed\n"
+        "M - Render mode\n"
+        "V - Top/isometric view\n"
+        "O - Profiler");
 
-    float current_zoom = 1.0f;
-
-    // Инициализируем генератор случайных чисел
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::exponential_distribution<float> poisson_dist(1.0f / settings.mean_free_path); // λ = 1/l
-    std::normal_distribution<float> gaussian_dist(0.0, 1.0);
+    int fast_steps_per_frame = settings.steps_per_frame;
 
     while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed)
-                window.close();
-
-            if (event.type == sf::Event::KeyPressed) {
-                if (event.key.code == sf::Keyboard::Q)
-                    return;
-                if (event.key.code == sf::Keyboard::H)
-                    show_controls = !show_controls;
-                if (event.key.code == sf::Keyboard::T) {
-                    is_dark_theme = !is_dark_theme;
-                    controls.setFillColor(is_dark_theme ? sf::Color::White : sf::Color::Black);
-                    window.clear(is_dark_theme ? sf::Color(30, 30, 30) : sf::Color(245, 245, 245));
-                }
-                if (event.key.code == sf::Keyboard::Space)
-                    paused = !paused;
-                if (event.key.code == sf::Keyboard::R) {
-                    for (auto& p : particles) {
-                        p.position = sf::Vector2f(0, 0);
-                        p.path.clear();
-                        p.path.push_back(sf::Vertex(p.position, p.color));
+        view.profiler.begin_frame();
+
+        {
+            ScopedTimer events_timer(view.profiler, PROFILE_EVENTS);
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed)
+                    window.close();
+
+                if (event.type == sf::Event::KeyPressed) {
+                    if (event.key.code == sf::Keyboard::Q)
+                        return;
+                    if (event.key.code == sf::Keyboard::Space)
+                        runner.set_paused(!runner.paused());
+                    if (event.key.code == sf::Keyboard::R) {
+                        runner.request_reset();
+                        view.clear_visits();
                     }
-                    current_step = 0;
-                }
-                if (event.key.code == sf::Keyboard::P)
-                    show_paths = !show_paths;
-                if (event.key.code == sf::Keyboard::Tab)
-                    info_mode = !info_mode; // Переключает между CDF и PDF
-                if (event.key.code == sf::Keyboard::LShift || event.key.code == sf::Keyboard::RShift)
-                    show_plot_mode = !show_plot_mode;
-
-                // Камера и зум
-                int left    = sf::Keyboard::isKeyPressed(sf::Keyboard::Left );
-                int right   = sf::Keyboard::isKeyPressed(sf::Keyboard::Right);
-                int up      = sf::Keyboard::isKeyPressed(sf::Keyboard::Up   );
-                int down    = sf::Keyboard::isKeyPressed(sf::Keyboard::Down );
-                bool zoom   = sf::Keyboard::isKeyPressed(sf::Keyboard::Z );
-                bool reduce = sf::Keyboard::isKeyPressed(sf::Keyboard::X );
-
-                float offset_x = current_zoom * MOVE_CAMERA_FACTOR * (right - left);
-                float offset_y = current_zoom * MOVE_CAMERA_FACTOR * (down - up);
-                camera.move(offset_x, offset_y);
-
-                if (zoom) {
-                    current_zoom *= ZOOM_IN_CAMERA_FACTOR;
-                    camera.zoom(ZOOM_IN_CAMERA_FACTOR);
-                }
-                if (reduce) {
-                    current_zoom *= ZOOM_OUT_CAMERA_FACTOR;
-                    camera.zoom(ZOOM_OUT_CAMERA_FACTOR);
+                    if (event.key.code == sf::Keyboard::F) {
+                        // Переключение между заданным темпом и «как можно быстрее»
+                        if (runner.steps_per_frame() == 0) {
+                            runner.set_steps_per_frame(fast_steps_per_frame > 0 ? fast_steps_per_frame : 1);
+                        } else {
+                            fast_steps_per_frame = runner.steps_per_frame();
+                            runner.set_steps_per_frame(0);
+                        }
+                    }
+                    view.handle_key(event.key.code);
                 }
             }
         }
 
-        // Обновление позиций частиц
-        if (!paused && current_step < MAX_STEPS) {
-            for (auto& p : particles) {
-                float step = poisson_dist(gen);
-                float dx = gaussian_dist(gen) * step / sqrt(2);
-                float dy = gaussian_dist(gen) * step / sqrt(2);
-                p.position.x += dx;
-                p.position.y += dy;
-                p.path.push_back(sf::Vertex(p.position, p.color));
-            }
-            current_step++;
-            update_histogram_data(particles, settings.mean_free_path, current_step);
-            sf::sleep(sf::microseconds(settings.delay));
-        }
-
-        window.clear(is_dark_theme ? sf::Color(30, 30, 30) : sf::Color(245, 245, 245));
-
-        if (!show_plot_mode) {
-            window.setView(camera);
-            float min_x = camera.getCenter().x - camera.getSize().x / 2.f;
-            float max_x = camera.getCenter().x + camera.getSize().x / 2.f;
-            float min_y = camera.getCenter().y - camera.getSize().y / 2.f;
-            float max_y = camera.getCenter().y + camera.getSize().y / 2.f;
-
-            sf::Color grid_color = is_dark_theme ? sf::Color(80, 80, 80) : sf::Color(180, 180, 180);
-            sf::Color axis_color = is_dark_theme ? sf::Color::White : sf::Color::Black;
-
-            float grid_step = settings.mean_free_path * 10;
-            float start_x = std::floor(min_x / grid_step) * grid_step;
-            float end_x   = std::ceil(max_x / grid_step) * grid_step;
-            float start_y = std::floor(min_y / grid_step) * grid_step;
-            float end_y   = std::ceil(max_y / grid_step) * grid_step;
-
-            for (float x = start_x; x <= end_x; x += grid_step) {
-                sf::Vertex line[] = {
-                    sf::Vertex(sf::Vector2f(x, min_y), grid_color),
-                    sf::Vertex(sf::Vector2f(x, max_y), grid_color)
-                };
-                window.draw(line, 2, sf::Lines);
-            }
+        // Разрешаем потоку симуляции следующую порцию шагов и берём свежий снимок
+        auto snapshot_start = FrameProfiler::Clock::now();
+        runner.grant_frame();
+        const Snapshot& snapshot = runner.latest();
+        view.profiler.add(PROFILE_SNAPSHOT, snapshot_start,
+                          std::chrono::duration<double>(FrameProfiler::Clock::now() - snapshot_start).count());
+        view.profiler.add(PROFILE_STEP, runner.take_step_seconds());
+
+        view.draw(snapshot.particles, snapshot.moments, &runner.trajectories(), &runner.paths_mutex(),
+                  runner.msd_series(), &runner.passage_monitor(), &runner.history_mutex());
+        view.present();
+    }
+}
 
-            for (float y = start_y; y <= end_y; y += grid_step) {
-                sf::Vertex line[] = {
-                    sf::Vertex(sf::Vector2f(min_x, y), grid_color),
-                    sf::Vertex(sf::Vector2f(max_x, y), grid_color)
-                };
-                window.draw(line, 2, sf::Lines);
-            }
+// === Воспроизведение записанного файла траекторий ===
+// Позиция — дробный номер кадра: на скорости ниже 1 кадр файла держится
+// несколько кадров окна. Кадр копируется из отображения только при смене номера.
+int run_replay(sf::RenderWindow& window, sf::Font& font, Settings settings,
+               const char* path, const OutputOptions& output) {
+    TrajectoryReader reader;
+    if (!reader.open(path))
+        return -1;
+
+    const TrajectoryFileHeader& header = reader.header();
+    const long long frame_count = reader.frame_count();
+    settings.particle_count = reader.particle_count();
+    settings.mean_free_path = static_cast<int>(header.mean_free_path);
+    settings.delay          = static_cast<int>(header.delay);
+    settings.dimension      = reader.dimension();
+    settings.seed           = header.seed;
+
+    // Симуляции нет, и пул карт плотности ни с кем не делится
+    WorkerPool pool(settings.thread_count);
+    SimulationView view(window, font, settings, output, reader.frame_step(frame_count - 1), pool,
+        "Usage:\n"
+        "Q - Quit\n"
+        "T - Toggle Theme\n"
+        "H - Hide/Show controls\n"
+        "Space - Play/Pause\n"
+        "B - Reverse\n"
+        "[ / ] - Slower/Faster\n"
+        ", / . - Previous/Next frame\n"
+        "Home/End, PgUp/PgDn - Seek\n"
+        "Click bar - Seek\n"
+        "R - Restart\n"
+        "Z/X - Zoom\n"
+        "Tab - Switch plot CDF/PDF/MSD/passage\n"
+        "Shift - Show plot\n"
+        "M - Render mode\n"
+        "V - Top/isometric view\n"
+        "O - Profiler");
+
+    ParticleEnsemble particles(settings.particle_count, settings.dimension);
+    const long long last = frame_count - 1;
+    double position = 0.0;
+    double speed = 1.0; // кадров файла за кадр окна
+    int direction = 1;
+    bool paused = false;
+    long long shown = -1;
+    EnsembleMoments moments;
+    MsdSeries msd;
+    int last_msd_step = -1;
+
+    const float bar_left   = 80.f;
+    const float bar_width  = WINDOW_WIDTH - 160.f;
+    const float bar_top    = WINDOW_HEIGHT - 30.f;
+    const float bar_height = 8.f;
+
+    auto seek = [&](double frame) {
+        position = std::clamp(frame, 0.0, static_cast<double>(last));
+    };
 
-            // Оси координат
-            sf::Vertex axis_x[] = {
-                sf::Vertex(sf::Vector2f(-1e6, 0), axis_color),
-                sf::Vertex(sf::Vector2f(1e6, 0), axis_color)
-            };
-            sf::Vertex axis_y[] = {
-                sf::Vertex(sf::Vector2f(0, -1e6), axis_color),
-                sf::Vertex(sf::Vector2f(0, 1e6), axis_color)
-            };
-            window.draw(axis_x, 2, sf::Lines);
-            window.draw(axis_y, 2, sf::Lines);
-
-            if (show_paths) {
-                for (const auto& p : particles) {
-                    if (!p.path.empty())
-                        window.draw(&p.path[0], p.path.size(), sf::LineStrip);
+    while (window.isOpen()) {
+        view.profiler.begin_frame();
+
+        {
+            ScopedTimer events_timer(view.profiler, PROFILE_EVENTS);
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed)
+                    window.close();
+
+                if (event.type == sf::Event::MouseButtonPressed &&
+                    event.mouseButton.y >= bar_top - 10 && event.mouseButton.y <= bar_top + bar_height + 10) {
+                    seek((event.mouseButton.x - bar_left) / bar_width * last);
                 }
-            }
-
-            for (const auto& p : particles) {
-                sf::CircleShape dot(current_zoom);
-                dot.setFillColor(sf::Color::Red);
-                dot.setPosition(p.position.x - current_zoom, p.position.y - current_zoom);
-                window.draw(dot);
-            }
 
-            float radius = 2 * settings.mean_free_path * sqrt(current_step);
-            if (radius > 0) {
-                sf::CircleShape dynamic_circle(radius);
-                dynamic_circle.setOrigin(radius, radius);
-                dynamic_circle.setPosition(0.f, 0.f);
-                dynamic_circle.setOutlineThickness(pow(current_step, 0.25f) * current_zoom);
-                dynamic_circle.setOutlineColor(sf::Color(128, 128, 128));
-                dynamic_circle.setFillColor(sf::Color::Transparent);
-                window.draw(dynamic_circle);
+                if (event.type == sf::Event::KeyPressed) {
+                    const sf::Keyboard::Key key = event.key.code;
+                    if (key == sf::Keyboard::Q)
+                        return 0;
+                    if (key == sf::Keyboard::Space) {
+                        // Play в конце записи начинает её сначала
+                        if (paused && direction > 0 && position >= last)
+                            seek(0);
+                        if (paused && direction < 0 && position <= 0)
+                            seek(last);
+                        paused = !paused;
+                    }
+                    if (key == sf::Keyboard::B)
+                        direction = -direction;
+                    if (key == sf::Keyboard::LBracket)
+                        speed = std::max(1.0 / 16, speed / 2);
+                    if (key == sf::Keyboard::RBracket)
+                        speed = std::min(1024.0, speed * 2);
+                    if (key == sf::Keyboard::Comma) {
+                        paused = true;
+                        seek(std::floor(position) - 1);
+                    }
+                    if (key == sf::Keyboard::Period) {
+                        paused = true;
+                        seek(std::floor(position) + 1);
+                    }
+                    if (key == sf::Keyboard::Home)
+                        seek(0);
+                    if (key == sf::Keyboard::End)
+                        seek(last);
+                    if (key == sf::Keyboard::PageUp)
+                        seek(position - 0.1 * frame_count);
+                    if (key == sf::Keyboard::PageDown)
+                        seek(position + 0.1 * frame_count);
+                    if (key == sf::Keyboard::R) {
+                        seek(0);
+                        view.clear_visits();
+                    }
+                    view.handle_key(key);
+                }
             }
+        }
 
-            window.setView(window.getDefaultView());
-            if (show_controls) {
-                controls.setFillColor(is_dark_theme ? sf::Color::White : sf::Color::Black);
-                window.draw(controls);
-            }
+        auto snapshot_start = FrameProfiler::Clock::now();
+        if (!paused) {
+            seek(position + direction * speed);
+            // На краю записи воспроизведение останавливается
+            if ((direction > 0 && position >= last) || (direction < 0 && position <= 0))
+                paused = true;
+        }
 
-            // === Эмпирический расчёт коэффициента диффузии D ===
-            float sum_r_squared = 0.0f;
-            for (const auto& p : particles) {
-                float r = std::sqrt(p.position.x * p.position.x + p.position.y * p.position.y);
-                sum_r_squared += r * r;
-            }
-            float avg_r_squared = sum_r_squared / settings.particle_count;
+        const long long frame = static_cast<long long>(position);
+        if (frame != shown) {
+            reader.read_frame(frame, particles);
+            // В файле только координаты: моменты кадра считаются одним проходом при смене кадра
+            moments = measure_moments(particles, reader.frame_step(frame));
+            // MSD(t) копится по показанным кадрам; шаг назад начинает ряд заново
+            if (moments.step < last_msd_step)
+                msd.clear();
+            msd.record(moments.step, moments.mean_r_squared);
+            last_msd_step = moments.step;
+            shown = frame;
+            reader.prefetch(frame + direction * std::max(1LL, static_cast<long long>(speed)));
+        }
+        const int current_step = moments.step;
+        view.profiler.add(PROFILE_SNAPSHOT, snapshot_start,
+                          std::chrono::duration<double>(FrameProfiler::Clock::now() - snapshot_start).count());
 
-            float time = static_cast<float>(current_step * settings.delay);
-            float D_empirical = avg_r_squared / (4.0f * time);
+        view.draw(particles, moments, nullptr, nullptr, msd, nullptr, nullptr);
 
-            // Вывод значения D на экран
-            sf::Text label_D("D = " + std::to_string(D_empirical).substr(0, 6) + " nm/sec^2", font, 22);
-            label_D.setFillColor(sf::Color::Green);
-            label_D.setPosition(WINDOW_WIDTH - 275, 30);
-            window.draw(label_D);
-        } else {
-            if (info_mode == 0)
-                draw_histogram_with_rayleigh(window, font, particles, settings.particle_count, settings.mean_free_path, current_step);
-            else
-                draw_histogram_pdf(window, font, particles, settings.particle_count, settings.mean_free_path, current_step);
+        {
+            // Полоса прокрутки и состояние воспроизведения
+            ScopedTimer hud_timer(view.profiler, PROFILE_HUD);
+            window.setView(window.getDefaultView());
+            const sf::Color color = view.dark_theme() ? sf::Color::White : sf::Color::Black;
+
+            sf::RectangleShape bar(sf::Vector2f(bar_width, bar_height));
+            bar.setPosition(bar_left, bar_top);
+            bar.setFillColor(sf::Color::Transparent);
+            bar.setOutlineColor(color);
+            bar.setOutlineThickness(1.f);
+            window.draw(bar);
+
+            sf::RectangleShape done(sf::Vector2f(last > 0 ? bar_width * frame / last : bar_width, bar_height));
+            done.setPosition(bar_left, bar_top);
+            done.setFillColor(sf::Color(160, 120, 140));
+            window.draw(done);
+
+            char status[128];
+            snprintf(status, sizeof(status), "frame %lld / %lld   step %d   speed %s%g   %s",
+                     frame + 1, frame_count, current_step, direction > 0 ? "" : "-", speed,
+                     paused ? "paused" : "playing");
+            sf::Text label(status, font, 14);
+            label.setFillColor(color);
+            label.setPosition(bar_left, bar_top - 24);
+            window.draw(label);
         }
 
-        window.display();
+        view.present();
     }
+    return 0;
 }
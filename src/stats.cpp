@@ -0,0 +1,96 @@
+#include "stats.h"
+#include <algorithm>
+#include <cmath>
+
+void EnsembleStats::bind(const ParticleEnsemble& particles, const EnsembleMoments& moments,
+                         float mean_free_path, int delay) {
+    if (this->particles == &particles && moments.step == moments_.step && mean_free_path == mean_free_path_)
+        return;
+
+    this->particles = &particles;
+    moments_ = moments;
+    mean_free_path_ = mean_free_path;
+    this->delay = delay;
+    dirty = DIRTY_ALL;
+}
+
+float EnsembleStats::sigma_squared() const {
+    float sigma_sq = mean_free_path_ * mean_free_path_ * moments_.step * 2.0f / moments_.dimension;
+    return sigma_sq <= 1e-5f ? 1e-5f : sigma_sq;
+}
+
+const RadialHistogram& EnsembleStats::histogram() {
+    if (dirty & DIRTY_HISTOGRAM) {
+        histogram_.build(particles->x.data(), particles->y.data(), particles->z_data(), particles->count);
+        dirty &= ~DIRTY_HISTOGRAM;
+    }
+    return histogram_;
+}
+
+// === Накопленная доля частиц против CDF χ-распределения ===
+const RadialCurve& EnsembleStats::cdf() {
+    if (dirty & DIRTY_CDF) {
+        const RadialHistogram& h = histogram();
+        const float sigma_sq = sigma_squared();
+        const float total = std::max(h.total, 1);
+
+        cdf_.max_radius = h.max_radius();
+        cdf_.radii.resize(CURVE_POINT_COUNT);
+        cdf_.empirical.resize(CURVE_POINT_COUNT);
+        cdf_.theory.resize(CURVE_POINT_COUNT);
+
+        for (int i = 0; i < CURVE_POINT_COUNT; ++i) {
+            const float r = cdf_.max_radius * i / (CURVE_POINT_COUNT - 1);
+            cdf_.radii[i] = r;
+            cdf_.empirical[i] = h.count_within(r) / total;
+            cdf_.theory[i] = static_cast<float>(chi_cdf(dimension(), r, sigma_sq));
+        }
+        dirty &= ~DIRTY_CDF;
+    }
+    return cdf_;
+}
+
+// === Плотность по радиусу против PDF χ-распределения ===
+const RadialCurve& EnsembleStats::pdf() {
+    if (dirty & DIRTY_PDF) {
+        const RadialHistogram& h = histogram();
+        const float sigma_sq = sigma_squared();
+        const float total = std::max(h.total, 1);
+
+        pdf_.max_radius = h.max_radius();
+        pdf_.radii.resize(CURVE_POINT_COUNT);
+        pdf_.empirical.resize(CURVE_POINT_COUNT);
+        pdf_.theory.resize(CURVE_POINT_COUNT);
+
+        const float dr = pdf_.max_radius / (CURVE_POINT_COUNT - 1);
+        float previous = 0.0f;
+        for (int i = 0; i < CURVE_POINT_COUNT; ++i) {
+            const float r = dr * i;
+            const float count = h.count_within(r);
+            pdf_.radii[i] = r;
+            pdf_.empirical[i] = (count - previous) / (dr * total);
+            pdf_.theory[i] = static_cast<float>(chi_pdf(dimension(), r, sigma_sq));
+            previous = count;
+        }
+        dirty &= ~DIRTY_PDF;
+    }
+    return pdf_;
+}
+
+// === Согласие гистограммы с χ-распределением ===
+const GoodnessOfFit& EnsembleStats::goodness() {
+    if (dirty & DIRTY_FIT) {
+        goodness_ = chi_goodness(histogram(), dimension(), sigma_squared());
+        dirty &= ~DIRTY_FIT;
+    }
+    return goodness_;
+}
+
+float EnsembleStats::rms_radius() const {
+    return std::sqrt(mean_r_squared());
+}
+
+float EnsembleStats::diffusion_coefficient() const {
+    const float time = static_cast<float>(moments_.step * delay);
+    return mean_r_squared() / (2.0f * dimension() * time);
+}
@@ -0,0 +1,188 @@
+#include "step_engine.h"
+#include <algorithm>
+#include <cmath>
+
+StepEngine::StepEngine(int thread_count, unsigned seed, float mean_free_path, Domain domain)
+    : seed(seed),
+      mean_free_path(mean_free_path),
+      domain_(domain),
+      streams(std::max(1, thread_count)),
+      pool(static_cast<int>(streams.size())) {
+    seed_streams();
+}
+
+void StepEngine::seed_streams() {
+    for (size_t i = 0; i < streams.size(); ++i) {
+        streams[i].sampler.seed(seed, i);
+        streams[i].step.resize(STEP_BLOCK);
+        streams[i].gauss_x.resize(STEP_BLOCK);
+        streams[i].gauss_y.resize(STEP_BLOCK);
+        streams[i].gauss_z.resize(STEP_BLOCK);
+    }
+}
+
+void StepEngine::reset() {
+    seed_streams();
+}
+
+void StepEngine::save_streams(std::vector<SamplerState>& states) const {
+    states.resize(streams.size());
+    for (size_t i = 0; i < streams.size(); ++i)
+        states[i] = streams[i].sampler.state;
+}
+
+bool StepEngine::restore_streams(const std::vector<SamplerState>& states) {
+    if (states.size() != streams.size())
+        return false;
+    for (size_t i = 0; i < streams.size(); ++i)
+        streams[i].sampler.state = states[i];
+    return true;
+}
+
+// Смещение частицы — D нормальных величин, умноженных на длину шага и 1/√D:
+// ⟨Δr²⟩ = 2λ² в любом числе измерений, на каждую ось приходится 2λ²/D.
+template <int D, typename Boundary>
+void StepEngine::step_range(int index, ParticleEnsemble& particles, const Boundary& boundary) {
+    const int chunks = static_cast<int>(streams.size());
+    const int begin = WorkerPool::chunk_begin(particles.count, index, chunks);
+    const int end   = WorkerPool::chunk_begin(particles.count, index + 1, chunks);
+
+    StepStream& s = streams[index];
+    float* x = particles.x.data();
+    float* y = particles.y.data();
+    float* z = particles.z.data();
+    const float inv_sqrt_d = 1.0f / std::sqrt(static_cast<float>(D));
+
+    float* step = s.step.data();
+    float* gx = s.gauss_x.data();
+    float* gy = s.gauss_y.data();
+    float* gz = s.gauss_z.data();
+    MomentSums& sums = s.sums;
+    sums = MomentSums{};
+    uint32_t* passage_mask = passage ? passage->mask_data() : nullptr;
+
+    // При поглощении выжившие пишутся подряд с начала куска: write <= i + j,
+    // поэтому ещё не прочитанные частицы не затираются
+    int write = begin;
+
+    // Длины шагов ~ Exp(1/l), направления — нормальные величины по каждой оси
+    for (int i = begin; i < end; i += STEP_BLOCK) {
+        const int n = std::min(STEP_BLOCK, end - i);
+        s.sampler.fill_exponential(step, n, mean_free_path);
+        if constexpr (D == 1) {
+            // Генератор выдаёт пары: обе половины пары идут в один массив
+            const int half = (n + 1) / 2;
+            s.sampler.fill_gaussian(gx, gx + half, half);
+        } else {
+            s.sampler.fill_gaussian(gx, gy, n);
+        }
+        if constexpr (D == 3) {
+            const int half = (n + 1) / 2;
+            s.sampler.fill_gaussian(gz, gz + half, half);
+        }
+
+        const int first = write;
+        for (int j = 0; j < n; ++j) {
+            float px = x[i + j] + gx[j] * step[j] * inv_sqrt_d;
+            float py = 0.0f, pz = 0.0f;
+            if constexpr (D >= 2)
+                py = y[i + j] + gy[j] * step[j] * inv_sqrt_d;
+            if constexpr (D == 3)
+                pz = z[i + j] + gz[j] * step[j] * inv_sqrt_d;
+
+            int slot = i + j;
+            if constexpr (Boundary::ABSORBS) {
+                // Запись без ветвления: выбывшую частицу перезапишет следующая
+                slot = write;
+                write += boundary.template inside<D>(px, py, pz);
+                if (passage_mask)
+                    passage_mask[slot] = passage_mask[i + j];
+            } else {
+                boundary.template apply<D>(px, py, pz);
+            }
+            x[slot] = px;
+            if constexpr (D >= 2)
+                y[slot] = py;
+            if constexpr (D == 3)
+                z[slot] = pz;
+        }
+        if constexpr (!Boundary::ABSORBS)
+            write += n;
+
+        // Моменты новых координат — пока блок ещё в L1, без второго прохода по памяти
+        accumulate_block<D>(x + first, y + first, D == 3 ? z + first : nullptr, write - first, sums);
+        if (passage)
+            passage->observe<D>(index, x + first, y + first, D == 3 ? z + first : nullptr, first, write - first);
+    }
+    s.kept = write - begin;
+}
+
+// Сдвигает выживших из кусков к началу массивов; куски идут по порядку,
+// поэтому приёмник каждого не заходит на ещё не сдвинутые куски
+void StepEngine::compact_chunks(ParticleEnsemble& particles) {
+    const int chunks = static_cast<int>(streams.size());
+    int write = 0;
+    for (int index = 0; index < chunks; ++index) {
+        const int begin = WorkerPool::chunk_begin(particles.count, index, chunks);
+        const int kept = streams[index].kept;
+        if (write != begin) {
+            std::copy(particles.x.begin() + begin, particles.x.begin() + begin + kept, particles.x.begin() + write);
+            if (particles.dimension >= 2)
+                std::copy(particles.y.begin() + begin, particles.y.begin() + begin + kept, particles.y.begin() + write);
+            if (particles.dimension == 3)
+                std::copy(particles.z.begin() + begin, particles.z.begin() + begin + kept, particles.z.begin() + write);
+            if (passage)
+                std::copy(passage->mask_data() + begin, passage->mask_data() + begin + kept, passage->mask_data() + write);
+        }
+        write += kept;
+    }
+    particles.count = write;
+}
+
+template <int D>
+void StepEngine::step_dimension(ParticleEnsemble& particles) {
+    const float size = domain_.size;
+    switch (domain_.kind) {
+        case BOUNDARY_PERIODIC: {
+            const PeriodicBoundary boundary(size);
+            pool.run([&](int index) { step_range<D>(index, particles, boundary); });
+            break;
+        }
+        case BOUNDARY_REFLECTING: {
+            const ReflectingBoundary boundary(size);
+            pool.run([&](int index) { step_range<D>(index, particles, boundary); });
+            break;
+        }
+        case BOUNDARY_ABSORBING: {
+            const AbsorbingBoundary boundary(size);
+            pool.run([&](int index) { step_range<D>(index, particles, boundary); });
+            compact_chunks(particles);
+            break;
+        }
+        case BOUNDARY_CIRCULAR: {
+            const CircularBoundary boundary(size);
+            pool.run([&](int index) { step_range<D>(index, particles, boundary); });
+            break;
+        }
+        default: {
+            const OpenBoundary boundary(size);
+            pool.run([&](int index) { step_range<D>(index, particles, boundary); });
+            break;
+        }
+    }
+}
+
+void StepEngine::step(ParticleEnsemble& particles) {
+    switch (particles.dimension) {
+        case 1:  step_dimension<1>(particles); break;
+        case 3:  step_dimension<3>(particles); break;
+        default: step_dimension<2>(particles); break;
+    }
+
+    // Куски складываются по номерам — сумма не зависит от того, кто закончил первым
+    total = MomentSums{};
+    for (const StepStream& s : streams)
+        total.add(s.sums);
+    count = particles.count;
+    dimension = particles.dimension;
+}
@@ -0,0 +1,272 @@
+#include "sweep.h"
+#include "config.h"
+#include "boundary.h"
+#include "ensemble.h"
+#include "step_engine.h"
+#include "moments.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+
+typedef struct SweepResult {
+    EnsembleMoments moments;
+    bool   fitted;
+    double alpha;
+    double D_fit;
+    double elapsed;
+} SweepResult;
+
+bool parse_sweep_args(int argc, char** argv, SweepOptions& options) {
+    static const char* const VALUE_FLAGS[] = {"--sweep", "-o", "-j", "--seed"};
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        bool known = false;
+        for (const char* flag : VALUE_FLAGS)
+            known = known || !strcmp(arg, flag);
+        if (!known) {
+            fprintf(stderr, "Unknown argument %s\n", arg);
+            return false;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (!strcmp(arg, "--sweep"))
+            options.grid_path = value;
+        else if (!strcmp(arg, "-j"))
+            options.thread_count = std::clamp(atoi(value), 1, MAX_THREAD_COUNT);
+        else if (!strcmp(arg, "--seed"))
+            options.seed = strtoul(value, nullptr, 10);
+        else
+            options.output_path = value;
+    }
+    return true;
+}
+
+// Тот же смеситель, что засевает BatchSampler: соседние номера прогонов дают несвязанные seed
+static unsigned run_seed(unsigned base_seed, int index) {
+    uint64_t z = (static_cast<uint64_t>(base_seed) << 32 | static_cast<uint32_t>(index)) + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<unsigned>(z ^ (z >> 31));
+}
+
+static void trim(std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r\n");
+    const size_t end = text.find_last_not_of(" \t\r\n");
+    text = begin == std::string::npos ? "" : text.substr(begin, end - begin + 1);
+}
+
+// Список положительных целых через запятую или пробел
+static bool parse_values(const std::string& text, std::vector<int>& values) {
+    values.clear();
+    const char* p = text.c_str();
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',')
+            ++p;
+        if (!*p)
+            break;
+        char* end;
+        const long value = strtol(p, &end, 10);
+        if (end == p || value <= 0)
+            return false;
+        values.push_back(static_cast<int>(value));
+        p = end;
+    }
+    return !values.empty();
+}
+
+bool load_sweep_grid(const char* path, unsigned base_seed, std::vector<SweepRun>& runs) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error while opening %s\n", path);
+        return false;
+    }
+
+    std::vector<int> particles = {DEFAULT_PARTICLE_COUNT};
+    std::vector<int> lambdas   = {DEFAULT_STEP_SIZE};
+    std::vector<int> delays    = {DEFAULT_DELAY};
+    std::vector<int> steps     = {MAX_STEPS};
+    std::vector<int> dimensions = {DEFAULT_DIMENSION};
+    std::vector<int> repeats   = {1};
+
+    char buffer[1024];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(buffer, sizeof(buffer), file)) {
+        ++line_number;
+        std::string line = buffer;
+        line = line.substr(0, line.find('#'));
+        trim(line);
+        if (line.empty())
+            continue;
+
+        const size_t equals = line.find('=');
+        std::string key = line.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : line.substr(equals + 1);
+        trim(key);
+
+        std::vector<int>* target = nullptr;
+        if (key == "particles" || key == "particle_count" || key == "n")
+            target = &particles;
+        else if (key == "mean_free_path" || key == "l")
+            target = &lambdas;
+        else if (key == "delay" || key == "t")
+            target = &delays;
+        else if (key == "steps" || key == "s")
+            target = &steps;
+        else if (key == "dimension" || key == "d")
+            target = &dimensions;
+        else if (key == "repeats")
+            target = &repeats;
+
+        const bool parsed = target && parse_values(value, *target);
+        const bool bad_dimension = target == &dimensions &&
+            std::any_of(dimensions.begin(), dimensions.end(), [](int d) { return d > MAX_DIMENSION; });
+        if (!parsed || (target == &repeats && repeats.size() != 1) || bad_dimension) {
+            fprintf(stderr, "%s:%d: expected 'key = positive integers', key one of "
+                            "particles, mean_free_path, delay, steps, dimension (1-3), repeats\n",
+                    path, line_number);
+            ok = false;
+        }
+    }
+    fclose(file);
+    if (!ok)
+        return false;
+
+    runs.clear();
+    for (int n : particles)
+        for (int lambda : lambdas)
+            for (int delay : delays)
+                for (int step_count : steps)
+                    for (int dimension : dimensions)
+                        for (int repeat = 0; repeat < repeats[0]; ++repeat) {
+                            SweepRun run;
+                            run.index = static_cast<int>(runs.size());
+                            run.repeat = repeat;
+                            run.steps = step_count;
+                            run.settings.particle_count  = n;
+                            run.settings.mean_free_path  = lambda;
+                            run.settings.delay           = delay;
+                            run.settings.dimension       = dimension;
+                            run.settings.boundary        = BOUNDARY_NONE;
+                            run.settings.domain_size     = DEFAULT_DOMAIN_SIZE;
+                            run.settings.thread_count    = 1;
+                            run.settings.seed            = run_seed(base_seed, run.index);
+                            run.settings.steps_per_frame = 0;
+                            run.settings.path_policy     = DEFAULT_PATH_POLICY;
+                            run.settings.path_budget_mb  = DEFAULT_PATH_BUDGET_MB;
+                            runs.push_back(run);
+                        }
+    return true;
+}
+
+// Один ансамбль в одном потоке: результат зависит только от настроек прогона
+static SweepResult run_ensemble(const SweepRun& run) {
+    auto start = std::chrono::steady_clock::now();
+
+    ParticleEnsemble particles(run.settings.particle_count, run.settings.dimension);
+    StepEngine engine(1, run.settings.seed, run.settings.mean_free_path);
+    MsdSeries msd;
+
+    SweepResult result;
+    result.moments = measure_moments(particles, 0);
+    for (int step = 1; step <= run.steps; ++step) {
+        engine.step(particles);
+        result.moments = engine.moments(step);
+        msd.record(step, result.moments.mean_r_squared);
+    }
+    result.alpha = 0.0;
+    result.D_fit = 0.0;
+    result.fitted = msd.fit(run.settings.delay, run.settings.dimension, result.alpha, result.D_fit);
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static void write_summary_row(FILE* out, const SweepRun& run, const SweepResult& result) {
+    const Settings& s = run.settings;
+    const double lambda_sq = static_cast<double>(s.mean_free_path) * s.mean_free_path;
+    const double time = static_cast<double>(run.steps) * s.delay;
+    const double mean_r_squared = result.moments.mean_r_squared;
+    const double d = s.dimension;
+
+    // χ-распределение в d измерениях: ⟨r²⟩ = dσ², поэтому оценка максимального правдоподобия σ² = ⟨r²⟩ / d
+    fprintf(out, "%d,%d,%d,%d,%d,%d,%d,%u,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.3f\n",
+            run.index, s.particle_count, s.mean_free_path, s.delay, run.steps, s.dimension, run.repeat, s.seed,
+            mean_r_squared, 2.0 * lambda_sq * run.steps,
+            time > 0 ? mean_r_squared / (2.0 * d * time) : 0.0, lambda_sq / (d * s.delay),
+            result.fitted ? result.alpha : 0.0, result.fitted ? result.D_fit : 0.0,
+            mean_r_squared / d, 2.0 * lambda_sq * run.steps / d,
+            result.moments.non_gaussian(), result.elapsed);
+}
+
+int run_sweep(const SweepOptions& options) {
+    std::vector<SweepRun> runs;
+    if (!load_sweep_grid(options.grid_path.c_str(), options.seed, runs))
+        return -1;
+
+    FILE* out = stdout;
+    if (!options.output_path.empty()) {
+        out = fopen(options.output_path.c_str(), "w");
+        if (!out) {
+            fprintf(stderr, "Error while opening %s\n", options.output_path.c_str());
+            return -1;
+        }
+    }
+
+    // Крупные прогоны первыми: к концу серии остаются короткие, и потоки не простаивают
+    std::vector<int> order(runs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return static_cast<double>(runs[a].settings.particle_count) * runs[a].steps >
+               static_cast<double>(runs[b].settings.particle_count) * runs[b].steps;
+    });
+
+    // Сводка в порядке сетки, а не завершения: строка пишется, как только готовы
+    // все прогоны до неё, и прерванная серия оставляет в файле готовое начало
+    fprintf(out, "run,particles,mean_free_path,delay,steps,dimension,repeat,seed,mean_r_squared,theory_r_squared,"
+                 "D,theory_D,msd_alpha,msd_D_fit,sigma_sq,theory_sigma_sq,non_gaussian,elapsed_sec\n");
+    fflush(out);
+
+    std::vector<SweepResult> results(runs.size());
+    std::vector<char> finished(runs.size(), 0);
+    std::mutex flush_mutex;
+    int flushed = 0;
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+    const int total = static_cast<int>(runs.size());
+
+    auto start = std::chrono::steady_clock::now();
+    WorkerPool pool(std::min(options.thread_count, std::max(total, 1)));
+    pool.run([&](int) {
+        for (int k = next++; k < total; k = next++) {
+            const SweepRun& run = runs[order[k]];
+            results[run.index] = run_ensemble(run);
+            fprintf(stderr, "[%d/%d] run %d: n=%d l=%d t=%d d=%d steps=%d  %.2f s\n", ++done, total, run.index,
+                    run.settings.particle_count, run.settings.mean_free_path, run.settings.delay,
+                    run.settings.dimension, run.steps, results[run.index].elapsed);
+
+            std::lock_guard<std::mutex> lock(flush_mutex);
+            finished[run.index] = 1;
+            for (; flushed < total && finished[flushed]; ++flushed)
+                write_summary_row(out, runs[flushed], results[flushed]);
+            fflush(out);
+        }
+    });
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (out != stdout)
+        fclose(out);
+    fprintf(stderr, "%d runs on %d threads in %.2f s\n", total, pool.size(), elapsed);
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include "trajectory.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+void TrajectoryStore::configure(int particle_count, PathPolicy policy, size_t budget_bytes, int max_points) {
+    this->particle_count = particle_count;
+    policy_ = policy;
+
+    // У PATH_ADAPTIVE на ёмкость K приходится ещё K/2 точек запасной арены
+    const size_t share = policy_ == PATH_ADAPTIVE ? 3 : 2;
+    size_t per_particle = particle_count > 0 ? budget_bytes * 2 / (share * sizeof(PathPoint) * particle_count) : 0;
+    capacity_ = static_cast<int>(std::min<size_t>(per_particle, std::max(max_points, 0)));
+    if (capacity_ < 4)
+        capacity_ = 0;
+
+    // Без value-инициализации: страницы занимаются по мере записи столбцов.
+    // Арена того же размера остаётся прежней.
+    const size_t wanted = static_cast<size_t>(particle_count) * capacity_;
+    if (wanted != arena_points) {
+        points.reset(wanted > 0 ? new PathPoint[wanted] : nullptr);
+        arena_points = wanted;
+    }
+    const size_t staged_wanted = policy_ == PATH_ADAPTIVE ? static_cast<size_t>(particle_count) * (capacity_ / 2) : 0;
+    if (staged_wanted != staging_points) {
+        staging.reset(staged_wanted > 0 ? new PathPoint[staged_wanted] : nullptr);
+        staging_points = staged_wanted;
+    }
+
+    if (policy_ == PATH_ADAPTIVE && capacity_ > 0) {
+        row.resize(capacity_);
+        importance.resize(capacity_);
+        order.resize(capacity_);
+        segments.reserve(capacity_);
+    }
+    clear();
+}
+
+void TrajectoryStore::clear() {
+    stride_ = 1;
+    length_ = 0;
+    written = 0;
+    stored_ = 0;
+    slot_base = 0;
+    staged = false;
+    ++revision_;
+}
+
+// Позиции всех частиц — столбец ячейки slot
+static void write_column(PathPoint* column, const float* x, const float* y, int count) {
+    for (int i = 0; i < count; ++i)
+        column[i] = PathPoint{x[i], y[i]};
+}
+
+void TrajectoryStore::record(const float* x, const float* y, int step) {
+    if (!enabled())
+        return;
+
+    PathPoint* base = points.get();
+    const size_t n = particle_count;
+
+    switch (policy_) {
+        case PATH_RING: {
+            const size_t slot = written % capacity_;
+            write_column(base + slot * n, x, y, particle_count);
+            ++written;
+            ++stored_;
+            length_ = static_cast<int>(std::min<long long>(written, capacity_));
+            break;
+        }
+
+        case PATH_STRIDE: {
+            if (step % stride_ != 0)
+                return;
+            if (length_ == capacity_) {
+                halve_stride();
+                if (step % stride_ != 0)
+                    return;
+            }
+            write_column(base + length_ * n, x, y, particle_count);
+            ++length_;
+            ++stored_;
+            break;
+        }
+
+        case PATH_ADAPTIVE: {
+            // Частицы пишутся синхронно, поэтому переполняются на одном и том же шаге
+            if (length_ == capacity_) {
+                if (!staged)
+                    prepare_simplify();
+                std::memcpy(base, staging.get(), staging_points * sizeof(PathPoint));
+                staged = false;
+                length_ = capacity_ / 2;
+                slot_base = stored_ - length_;
+                ++revision_;
+            }
+            write_column(base + length_ * n, x, y, particle_count);
+            ++length_;
+            ++stored_;
+            break;
+        }
+    }
+}
+
+void TrajectoryStore::prepare_simplify() {
+    if (!simplify_due() || staged)
+        return;
+    for (int i = 0; i < particle_count; ++i)
+        simplify(i, staging.get() + i);
+    staged = true;
+}
+
+// Оставляем точки с чётными номерами, шаг записи удваивается
+void TrajectoryStore::halve_stride() {
+    const int kept = (length_ + 1) / 2;
+    const size_t n = particle_count;
+    for (int k = 1; k < kept; ++k)
+        std::copy(points.get() + 2 * k * n, points.get() + (2 * k + 1) * n, points.get() + k * n);
+    length_ = kept;
+    stride_ *= 2;
+    slot_base = stored_ - kept;
+    ++revision_;
+}
+
+static float segment_distance_sq(const PathPoint& p, const PathPoint& a, const PathPoint& b) {
+    const float dx = b.x - a.x;
+    const float dy = b.y - a.y;
+    const float len_sq = dx * dx + dy * dy;
+    float t = len_sq > 0.0f ? ((p.x - a.x) * dx + (p.y - a.y) * dy) / len_sq : 0.0f;
+    t = std::clamp(t, 0.0f, 1.0f);
+    const float ex = a.x + t * dx - p.x;
+    const float ey = a.y + t * dy - p.y;
+    return ex * ex + ey * ey;
+}
+
+// === Прореживание одной траектории до половины ёмкости ===
+// Траектория собирается из столбцов в row, прореживается там и пишется в out
+// с тем же шагом между ячейками; арена не меняется.
+// Проход Дугласа–Пекера назначает каждой точке «важность» — отклонение от
+// хорды в момент, когда она была выбрана (не больше, чем у родителя).
+// Оставляем самые важные точки; концы сохраняются всегда.
+void TrajectoryStore::simplify(int particle, PathPoint* out) {
+    const int n = length_;
+    const size_t stride = particle_count;
+    const PathPoint* column = points.get() + particle;
+    for (int k = 0; k < n; ++k)
+        row[k] = column[k * stride];
+    const float inf = std::numeric_limits<float>::infinity();
+
+    std::fill(importance.begin(), importance.begin() + n, 0.0f);
+    importance[0] = inf;
+    importance[n - 1] = inf;
+
+    segments.clear();
+    segments.emplace_back(0, n - 1);
+    while (!segments.empty()) {
+        const int a = segments.back().first;
+        const int b = segments.back().second;
+        segments.pop_back();
+        if (b - a < 2)
+            continue;
+
+        int farthest = a + 1;
+        float max_dist = -1.0f;
+        for (int k = a + 1; k < b; ++k) {
+            const float d = segment_distance_sq(row[k], row[a], row[b]);
+            if (d > max_dist) {
+                max_dist = d;
+                farthest = k;
+            }
+        }
+
+        importance[farthest] = std::min(max_dist, std::min(importance[a], importance[b]));
+        segments.emplace_back(a, farthest);
+        segments.emplace_back(farthest, b);
+    }
+
+    const int keep = capacity_ / 2;
+    for (int k = 0; k < n; ++k)
+        order[k] = k;
+    std::nth_element(order.begin(), order.begin() + keep, order.begin() + n,
+                     [this](int l, int r) { return importance[l] > importance[r]; });
+    std::sort(order.begin(), order.begin() + keep);
+
+    for (int k = 0; k < keep; ++k)
+        out[k * stride] = row[order[k]];
+}
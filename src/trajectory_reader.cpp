@@ -0,0 +1,93 @@
+#include "trajectory_reader.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+
+TrajectoryReader::~TrajectoryReader() {
+    close();
+}
+
+bool TrajectoryReader::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error while opening %s\n", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TrajectoryFileHeader)) {
+        fprintf(stderr, "%s is not a trajectory file\n", path);
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // отображение держит файл само
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Error while mapping %s\n", path);
+        return false;
+    }
+    data = static_cast<const unsigned char*>(mapping);
+    size = info.st_size;
+
+    memcpy(&header_, data, sizeof(header_));
+    if (memcmp(header_.magic, TRAJECTORY_MAGIC, sizeof(header_.magic)) != 0 ||
+        header_.version != TRAJECTORY_VERSION ||
+        header_.header_bytes < sizeof(TrajectoryFileHeader) || header_.header_bytes > size ||
+        header_.particle_count == 0 || header_.dimension > 3) {
+        fprintf(stderr, "%s is not a trajectory file\n", path);
+        close();
+        return false;
+    }
+
+    // Число кадров из заголовка, если файл закрыт штатно; иначе — сколько целых кадров влезло
+    frame_bytes = trajectory_frame_bytes(header_.particle_count, trajectory_dimension(header_));
+    const long long complete = static_cast<long long>((size - header_.header_bytes) / frame_bytes);
+    frame_count_ = header_.frame_count > 0 && static_cast<long long>(header_.frame_count) <= complete
+                 ? static_cast<long long>(header_.frame_count) : complete;
+    if (frame_count_ == 0) {
+        fprintf(stderr, "%s has no frames\n", path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TrajectoryReader::close() {
+    if (data)
+        munmap(const_cast<unsigned char*>(data), size);
+    data = nullptr;
+    size = 0;
+    frame_count_ = 0;
+}
+
+int TrajectoryReader::frame_step(long long frame) const {
+    TrajectoryFrameHeader frame_header;
+    memcpy(&frame_header, frame_data(frame), sizeof(frame_header));
+    return frame_header.step;
+}
+
+void TrajectoryReader::read_frame(long long frame, ParticleEnsemble& particles) const {
+    const unsigned char* x = frame_data(frame) + sizeof(TrajectoryFrameHeader);
+    const size_t coordinates = sizeof(float) * header_.particle_count;
+    memcpy(particles.x.data(), x, coordinates);
+    memcpy(particles.y.data(), x + coordinates, coordinates);
+    if (particles.dimension == 3)
+        memcpy(particles.z.data(), x + 2 * coordinates, coordinates);
+}
+
+void TrajectoryReader::prefetch(long long frame) const {
+    if (frame < 0 || frame >= frame_count_)
+        return;
+
+    // madvise требует адрес, выровненный по странице
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = static_cast<size_t>(frame_data(frame) - data);
+    const size_t aligned = begin / page * page;
+    madvise(const_cast<unsigned char*>(data) + aligned, begin - aligned + frame_bytes, MADV_WILLNEED);
+}
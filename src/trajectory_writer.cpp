@@ -0,0 +1,152 @@
+#include "trajectory_writer.h"
+#include <algorithm>
+#include <cstring>
+
+TrajectoryWriter::~TrajectoryWriter() {
+    close();
+}
+
+bool TrajectoryWriter::open(const char* path, const Settings& settings, int stride) {
+    close();
+
+    file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error while opening %s\n", path);
+        return false;
+    }
+    // Буферизация своя, stdio только мешает лишним копированием
+    setvbuf(file, nullptr, _IONBF, 0);
+    this->path = path;
+
+    header = TrajectoryFileHeader{};
+    memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic));
+    header.version        = TRAJECTORY_VERSION;
+    header.header_bytes   = sizeof(TrajectoryFileHeader);
+    header.particle_count = static_cast<uint32_t>(settings.particle_count);
+    header.seed           = settings.seed;
+    header.mean_free_path = static_cast<float>(settings.mean_free_path);
+    header.stride         = static_cast<uint32_t>(std::max(1, stride));
+    header.delay          = static_cast<uint32_t>(settings.delay);
+    header.dimension      = static_cast<uint32_t>(settings.dimension);
+    header.frame_count    = 0;
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        fprintf(stderr, "Error while writing %s\n", path);
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    frame_bytes = trajectory_frame_bytes(header.particle_count, settings.dimension);
+    buffer_bytes = std::max(WRITER_BUFFER_BYTES, frame_bytes);
+    frames_submitted = 0;
+
+    free_buffers.clear();
+    for (int i = 0; i < WRITER_BUFFER_COUNT - 1; ++i) {
+        free_buffers.emplace_back();
+        free_buffers.back().reserve(buffer_bytes);
+    }
+    current.clear();
+    current.reserve(buffer_bytes);
+
+    stopping = false;
+    failed = false;
+    worker = std::thread(&TrajectoryWriter::writer_loop, this);
+    return true;
+}
+
+void TrajectoryWriter::submit(int step, const ParticleEnsemble& particles) {
+    if (!file || step % static_cast<int>(header.stride) != 0)
+        return;
+
+    if (current.size() + frame_bytes > buffer_bytes)
+        hand_off();
+
+    const size_t offset = current.size();
+    current.resize(offset + frame_bytes);
+    char* frame = current.data() + offset;
+
+    TrajectoryFrameHeader frame_header = {step, 0};
+    const size_t coordinates = sizeof(float) * header.particle_count;
+    memcpy(frame, &frame_header, sizeof(frame_header));
+    memcpy(frame + sizeof(frame_header), particles.x.data(), coordinates);
+    memcpy(frame + sizeof(frame_header) + coordinates, particles.y.data(), coordinates);
+    if (header.dimension == 3)
+        memcpy(frame + sizeof(frame_header) + 2 * coordinates, particles.z.data(), coordinates);
+    ++frames_submitted;
+}
+
+// Отдаёт заполненный буфер потоку записи и берёт свободный
+void TrajectoryWriter::hand_off() {
+    if (current.empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    pending.push_back(std::move(current));
+    pending_cv.notify_one();
+
+    free_cv.wait(lock, [this] { return !free_buffers.empty(); });
+    current = std::move(free_buffers.back());
+    free_buffers.pop_back();
+    current.clear();
+}
+
+void TrajectoryWriter::writer_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        pending_cv.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty())
+            return;
+
+        std::vector<char> buffer = std::move(pending.front());
+        pending.pop_front();
+
+        lock.unlock();
+        if (!failed && fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            fprintf(stderr, "Error while writing %s\n", path.c_str());
+            failed = true;
+        }
+        lock.lock();
+
+        free_buffers.push_back(std::move(buffer));
+        free_cv.notify_one();
+    }
+}
+
+void TrajectoryWriter::close() {
+    if (!file)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!current.empty())
+            pending.push_back(std::move(current));
+        stopping = true;
+    }
+    pending_cv.notify_one();
+    worker.join();
+    current.clear();
+
+    // Число кадров в заголовке позволяет читателю не доверять размеру файла
+    if (!failed) {
+        header.frame_count = frames_submitted;
+        fseek(file, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, file);
+    }
+    fclose(file);
+    file = nullptr;
+}
+
+bool TrajectoryWriter::restart() {
+    if (!file)
+        return false;
+
+    Settings settings{};
+    settings.particle_count = static_cast<int>(header.particle_count);
+    settings.mean_free_path = static_cast<int>(header.mean_free_path);
+    settings.delay          = static_cast<int>(header.delay);
+    settings.dimension      = trajectory_dimension(header);
+    settings.seed           = header.seed;
+    const int stride = static_cast<int>(header.stride);
+    const std::string reopen_path = path;
+    return open(reopen_path.c_str(), settings, stride);
+}
@@ -0,0 +1,60 @@
+#include "worker_pool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int thread_count) {
+    for (int i = 1; i < std::max(1, thread_count); ++i)
+        workers.emplace_back(&WorkerPool::worker_loop, this, i);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void WorkerPool::run(const std::function<void(int)>& task) {
+    if (workers.empty()) {
+        task(0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &task;
+        pending = static_cast<int>(workers.size());
+        ++generation;
+    }
+    start_cv.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return pending == 0; });
+    current = nullptr;
+}
+
+void WorkerPool::worker_loop(int index) {
+    unsigned seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        start_cv.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping)
+            return;
+
+        seen = generation;
+        const std::function<void(int)>* task = current;
+
+        lock.unlock();
+        (*task)(index);
+        lock.lock();
+
+        if (--pending == 0)
+            done_cv.notify_one();
+    }
+}
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "sampler.h"
+
+// === Проверка пакетного генератора: make test ===
+// Моменты Exp и N(0, 1) против теории с допуском в несколько стандартных
+// ошибок выборки, и побитовое совпадение потоков скалярной, SSE2 и AVX2
+// веток. Ветки, которых нет у процессора, пропускаются.
+
+// Выборка на проверку моментов; стандартная ошибка эксцесса Exp при ней ≈ 0.1
+static const size_t MOMENT_SAMPLES = 4 * 1000 * 1000;
+// Длина порции не кратна числу дорожек: заодно проверяется хвост fill_*
+static const size_t CHUNK = 1000 + 3;
+static const uint64_t SEED = 12345;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, double value, double expected, double tolerance) {
+    printf("%-4s %-32s %10.6f  expected %10.6f ± %.6f\n", ok ? "ok" : "FAIL", what, value, expected, tolerance);
+    if (!ok)
+        ++failures;
+}
+
+static void check_close(const char* what, double value, double expected, double tolerance) {
+    check(std::fabs(value - expected) <= tolerance, what, value, expected, tolerance);
+}
+
+struct Moments {
+    double mean, variance, kurtosis;
+};
+
+static Moments sample_moments(const std::vector<float>& v) {
+    double mean = 0.0;
+    for (float x : v)
+        mean += x;
+    mean /= v.size();
+
+    double m2 = 0.0, m4 = 0.0;
+    for (float x : v) {
+        const double d = x - mean;
+        m2 += d * d;
+        m4 += d * d * d * d;
+    }
+    m2 /= v.size();
+    m4 /= v.size();
+    return Moments{mean, m2, m4 / (m2 * m2)};
+}
+
+static std::vector<float> exponential_stream(SamplerIsa isa, size_t n, float mean) {
+    BatchSampler sampler(isa);
+    sampler.seed(SEED, 1);
+    std::vector<float> out(n);
+    for (size_t done = 0; done < n; done += CHUNK)
+        sampler.fill_exponential(out.data() + done, std::min(CHUNK, n - done), mean);
+    return out;
+}
+
+static void gaussian_stream(SamplerIsa isa, size_t n, std::vector<float>& a, std::vector<float>& b) {
+    BatchSampler sampler(isa);
+    sampler.seed(SEED, 2);
+    a.resize(n);
+    b.resize(n);
+    for (size_t done = 0; done < n; done += CHUNK)
+        sampler.fill_gaussian(a.data() + done, b.data() + done, std::min(CHUNK, n - done));
+}
+
+// Exp(m): среднее m, дисперсия m², эксцесс 9
+static void test_exponential_moments(SamplerIsa isa) {
+    const float mean = 5.0f;
+    const Moments m = sample_moments(exponential_stream(isa, MOMENT_SAMPLES, mean));
+    const double n = static_cast<double>(MOMENT_SAMPLES);
+    // Стандартные ошибки: m / √n, m² √(8 / n), √((μ₈ - μ₄²) / n) / σ⁸ = √(40239 / n)
+    check_close("exponential mean", m.mean, mean, 5.0 * mean / std::sqrt(n));
+    check_close("exponential variance", m.variance, mean * mean, 5.0 * mean * mean * std::sqrt(8.0 / n));
+    check_close("exponential kurtosis", m.kurtosis, 9.0, 5.0 * std::sqrt(40239.0 / n));
+}
+
+// N(0, 1): среднее 0, дисперсия 1, эксцесс 3; пара a, b некоррелирована
+static void test_gaussian_moments(SamplerIsa isa) {
+    std::vector<float> a, b;
+    gaussian_stream(isa, MOMENT_SAMPLES, a, b);
+    const double n = static_cast<double>(MOMENT_SAMPLES);
+
+    const Moments ma = sample_moments(a);
+    const Moments mb = sample_moments(b);
+    check_close("gaussian a mean", ma.mean, 0.0, 5.0 / std::sqrt(n));
+    check_close("gaussian a variance", ma.variance, 1.0, 5.0 * std::sqrt(2.0 / n));
+    check_close("gaussian a kurtosis", ma.kurtosis, 3.0, 5.0 * std::sqrt(24.0 / n));
+    check_close("gaussian b mean", mb.mean, 0.0, 5.0 / std::sqrt(n));
+    check_close("gaussian b variance", mb.variance, 1.0, 5.0 * std::sqrt(2.0 / n));
+    check_close("gaussian b kurtosis", mb.kurtosis, 3.0, 5.0 * std::sqrt(24.0 / n));
+
+    double covariance = 0.0;
+    for (size_t i = 0; i < a.size(); ++i)
+        covariance += (a[i] - ma.mean) * (b[i] - mb.mean);
+    covariance /= n;
+    check_close("gaussian a-b correlation", covariance / std::sqrt(ma.variance * mb.variance), 0.0,
+                5.0 / std::sqrt(n));
+}
+
+static bool same_bytes(const std::vector<float>& l, const std::vector<float>& r) {
+    return l.size() == r.size() && memcmp(l.data(), r.data(), l.size() * sizeof(float)) == 0;
+}
+
+// Ветка isa против скалярной: те же биты на тех же seed и порциях
+static void test_identical_streams(SamplerIsa isa, size_t n) {
+    const bool exponential = same_bytes(exponential_stream(isa, n, 5.0f), exponential_stream(SAMPLER_SCALAR, n, 5.0f));
+
+    std::vector<float> a, b, scalar_a, scalar_b;
+    gaussian_stream(isa, n, a, b);
+    gaussian_stream(SAMPLER_SCALAR, n, scalar_a, scalar_b);
+    const bool gaussian = same_bytes(a, scalar_a) && same_bytes(b, scalar_b);
+
+    printf("%-4s %s exponential stream == scalar\n", exponential ? "ok" : "FAIL", sampler_isa_name(isa));
+    printf("%-4s %s gaussian stream == scalar\n", gaussian ? "ok" : "FAIL", sampler_isa_name(isa));
+    failures += !exponential + !gaussian;
+}
+
+int main() {
+    const SamplerIsa best = detect_sampler_isa();
+    const SamplerIsa isas[] = {SAMPLER_SCALAR, SAMPLER_SSE2, SAMPLER_AVX2};
+
+    for (SamplerIsa isa : isas) {
+        if (isa > best) {
+            printf("skip %s: not supported by this CPU\n", sampler_isa_name(isa));
+            continue;
+        }
+        printf("--- %s\n", sampler_isa_name(isa));
+        test_exponential_moments(isa);
+        test_gaussian_moments(isa);
+        if (isa != SAMPLER_SCALAR)
+            test_identical_streams(isa, MOMENT_SAMPLES);
+    }
+
+    if (failures > 0) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all sampler checks passed\n");
+    return 0;
+}